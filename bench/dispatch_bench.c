@@ -0,0 +1,176 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * Event throughput of the model. The first seed of the first sweep point of
+ * the configuration is run once, as a replication worker runs it, with
+ * everything the model prints thrown away, and the events per second of the
+ * run are printed. The configuration is read from the command line as by the
+ * simulation itself (see config.h):
+ *
+ *   dispatch_bench [-c file] [--key=value] ...
+ *
+ * Build from the top of the tree twice, once as is for event functions and
+ * once with -DTYPED_EVENT_DISPATCH for the kind switch, with TRACE_ON
+ * commented out in trace.h:
+ *
+ *   gcc -O2 -pthread -I. -o dispatch_bench bench/dispatch_bench.c \
+ *       $(ls *.c | grep -v '^main\.c$') -lm
+ *
+ * Adding -flto lets the compiler inline the event functions into the kind
+ * switch. The figures in the log were made with
+ *
+ *   ./dispatch_bench --p12_cutoff 0.5 --runlength 2000000 \
+ *       --random_seed_list 400050636
+ *
+ * and with the three per-packet fprintf() calls of
+ * switch_end_packet_transmission() taken out as well. Otherwise formatting
+ * those lines, into /dev/null, takes most of the time of each event.
+ */
+
+/******************************************************************************/
+
+/*
+ * clock_gettime() is POSIX, not C99.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simlib.h"
+#include "main.h"
+#include "config.h"
+#include "packet_arrival.h"
+#include "packet_table.h"
+#include "topology.h"
+#include "static_topology.h"
+#include "event_dispatch.h"
+#include "cleanup_memory.h"
+
+/******************************************************************************/
+
+static int
+run_length_reached(Simulation_Run_Ptr simulation_run, void * ctx)
+{
+  Simulation_Run_Data_Ptr data = (Simulation_Run_Data_Ptr) ctx;
+
+  (void) simulation_run;
+  return data->switches[0].number_of_packets_processed >=
+    data->config->runlength;
+}
+
+static double
+dispatch_bench_seconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+int
+main(int argc, char ** argv)
+{
+  Simulation_Run_Ptr simulation_run;
+  Simulation_Run_Data data;
+  Config config;
+  double packet_arrival_rate[3];
+  double p12_cutoff, start, seconds;
+  long int events;
+  FILE * discard;
+  Switch_Ptr sw;
+  int s;
+
+  config_init(&config);
+  config_load(&config, argc, argv);
+
+  memset(&data, 0, sizeof(data));
+  data.config = &config;
+  data.packets = packet_table_new();
+
+  simulation_run = simulation_run_new();
+  simulation_run_attach_data(simulation_run, (void *) & data);
+  simulation_run_set_eventlist_adaptive(simulation_run, 1);
+
+  discard = fopen("/dev/null", "w");
+  if (discard == NULL) {
+    printf("Error: Cannot open /dev/null.\n");
+    exit(1);
+  }
+  simulation_run_set_output(simulation_run, discard);
+
+  config_sweep_point(&config, 0, packet_arrival_rate, &p12_cutoff);
+  topology_three_switch(&data.topology, packet_arrival_rate,
+			config.packet_xmt_time, p12_cutoff);
+  switches_new(simulation_run);
+  switches_reset(simulation_run);
+
+  data.random_seed = (unsigned) config.random_seed_list.values[0];
+  simulation_run_random_initialize(simulation_run, data.random_seed);
+
+  start = dispatch_bench_seconds();
+
+#ifdef STATIC_TOPOLOGY
+  static_topology_start(simulation_run);
+#else
+  for (s = 0; s < data.topology.switch_count; s++) {
+    sw = &data.switches[s];
+    if (sw->config->packet_arrival_rate > 0)
+      schedule_packet_arrival_event(simulation_run,
+	    simulation_run_get_sim_time(simulation_run), sw);
+  }
+#endif
+
+#if defined(STATIC_TOPOLOGY)
+  run_events_static(simulation_run, run_length_reached, (void *) &data);
+#elif defined(TYPED_EVENT_DISPATCH)
+  run_events_by_kind(simulation_run, run_length_reached, (void *) &data);
+#else
+  simulation_run_run_until(simulation_run, -1.0, 0, run_length_reached,
+			   (void *) &data);
+#endif
+
+  seconds = dispatch_bench_seconds() - start;
+  events = simulation_run_events_executed(simulation_run);
+
+#if defined(STATIC_TOPOLOGY)
+  printf("static topology: ");
+#elif defined(TYPED_EVENT_DISPATCH)
+  printf("kind switch: ");
+#else
+  printf("event functions: ");
+#endif
+  printf("%ld events in %.3f sec, %.2f Mevents/s\n", events, seconds,
+	 1e-6 * events / seconds);
+
+  cleanup_memory(simulation_run);
+  fclose(discard);
+  config_free(&config);
+  return 0;
+}
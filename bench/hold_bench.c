@@ -0,0 +1,152 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * The hold model benchmark for the event list structures. The event list is
+ * filled with population events at exponentially distributed times. Each
+ * event, when it occurs, schedules one more at the current time plus an
+ * exponentially distributed increment, so the population stays the same.
+ * The time per event, including the random number draw, is printed for the
+ * given event list type:
+ *
+ *   hold_bench list|heap|calendar|radix population [events]
+ *
+ * events defaults to 2000000. Anything simlib traces is thrown away, but it
+ * is still formatted, so build from the top of the tree with TRACE_ON
+ * commented out in trace.h:
+ *
+ *   gcc -O2 -I. -o hold_bench bench/hold_bench.c simlib.c -lm
+ *
+ * The radix heap figures in the log were made with
+ *
+ *   for n in 3 10 100 1000 10000 100000 1000000; do
+ *     for t in list heap radix; do ./hold_bench $t $n; done
+ *   done
+ *
+ * The list takes O(population) per event, so use fewer events for it at the
+ * larger populations.
+ */
+
+/******************************************************************************/
+
+/*
+ * clock_gettime() is POSIX, not C99.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simlib.h"
+
+/******************************************************************************/
+
+#define HOLD_BENCH_EVENTS 2000000
+#define HOLD_BENCH_SEED 12345
+
+static void
+hold_event(Simulation_Run_Ptr simulation_run, void * attachment)
+{
+  Event event;
+
+  event.description = "Hold";
+  event.function = hold_event;
+  event.attachment = attachment;
+  simulation_run_schedule_event(simulation_run, event,
+		simulation_run_get_time(simulation_run) +
+		simulation_run_exponential_generator(simulation_run, 1.0));
+}
+
+static double
+hold_bench_seconds(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+int
+main(int argc, char ** argv)
+{
+  static const Eventlist_Type types[] = {EVENTLIST_LIST, EVENTLIST_HEAP,
+					 EVENTLIST_CALENDAR, EVENTLIST_RADIX};
+  Simulation_Run_Ptr simulation_run;
+  FILE * discard;
+  Event event;
+  long int population, events, k;
+  double start, seconds;
+  int t;
+
+  if (argc < 3) {
+    printf("Usage: %s list|heap|calendar|radix population [events]\n",
+	   argv[0]);
+    exit(1);
+  }
+
+  for (t = 0; t < 4; t++)
+    if (strcmp(argv[1], eventlist_type_name(types[t])) == 0)
+      break;
+  population = atol(argv[2]);
+  events = argc > 3 ? atol(argv[3]) : HOLD_BENCH_EVENTS;
+  if (t == 4 || population < 1 || events < 1) {
+    printf("Error: Bad event list type, population or event count.\n");
+    exit(1);
+  }
+
+  simulation_run = simulation_run_new();
+  simulation_run_set_eventlist_type(simulation_run, types[t]);
+  simulation_run_random_initialize(simulation_run, HOLD_BENCH_SEED);
+
+  discard = fopen("/dev/null", "w");
+  if (discard == NULL) {
+    printf("Error: Cannot open /dev/null.\n");
+    exit(1);
+  }
+  simulation_run_set_output(simulation_run, discard);
+
+  event.description = "Hold";
+  event.function = hold_event;
+  event.attachment = NULL;
+  for (k = 0; k < population; k++)
+    simulation_run_schedule_event(simulation_run, event,
+		  simulation_run_exponential_generator(simulation_run, 1.0));
+
+  start = hold_bench_seconds();
+  for (k = 0; k < events; k++)
+    simulation_run_execute_event(simulation_run);
+  seconds = hold_bench_seconds() - start;
+
+  printf("%-8s population %8ld  %10.1f ns/event  (sim time %f)\n",
+	 eventlist_type_name(types[t]), population, 1e9 * seconds / events,
+	 simulation_run_get_time(simulation_run));
+
+  simulation_run_free_memory(simulation_run);
+  fclose(discard);
+  return 0;
+}
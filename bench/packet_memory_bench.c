@@ -0,0 +1,146 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * Memory used per buffered packet. packets packets (1000000 by default) are
+ * created in a packet table and put on one packet queue, as a switch buffers
+ * them when its link is overloaded. The size of a Packet, and the bytes per
+ * packet of the packet table and of the growth of the resident set, are
+ * printed:
+ *
+ *   packet_memory_bench [packets]
+ *
+ * Build from the top of the tree:
+ *
+ *   gcc -O2 -I. -o packet_memory_bench bench/packet_memory_bench.c \
+ *       packet_table.c simlib.c -lm
+ *
+ * The table bytes are worked out from the table's chunks rather than with
+ * packet_table_bytes(), so the same driver also builds against the tree
+ * before Packet was packed, which gives the "before" figures in the log.
+ * main.h declares main(void) there, so add -DPACKET_MEMORY_BENCH_NO_ARGS
+ * and set the packet count with -DPACKET_MEMORY_BENCH_PACKETS=n. The
+ * resident set is read from /proc/self/status, so it needs Linux.
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "packet_table.h"
+
+/******************************************************************************/
+
+#ifndef PACKET_MEMORY_BENCH_PACKETS
+#define PACKET_MEMORY_BENCH_PACKETS 1000000
+#endif
+
+/*
+ * The resident set size of the process, in bytes.
+ */
+
+static long int
+resident_bytes(void)
+{
+  char line[256];
+  long int kb = 0;
+  FILE * fp;
+
+  fp = fopen("/proc/self/status", "r");
+  if (fp == NULL) {
+    printf("Error: Cannot open /proc/self/status.\n");
+    exit(1);
+  }
+  while (fgets(line, sizeof(line), fp) != NULL)
+    if (strncmp(line, "VmRSS:", 6) == 0)
+      kb = atol(line + 6);
+  fclose(fp);
+  return 1024 * kb;
+}
+
+/*
+ * Queue packets packets and print the memory they take.
+ */
+
+static int
+packet_memory_bench(long int packets)
+{
+  Packet_Table_Ptr table;
+  Packet_Queue queue;
+  Packet_Index packet;
+  long int k, resident, table_bytes;
+
+  resident = resident_bytes();
+  table = packet_table_new();
+  packet_queue_init(&queue);
+
+  for (k = 0; k < packets; k++) {
+    packet = packet_new(table);
+    PACKET_PTR(table, packet)->arrive_time = k;
+    PACKET_PTR(table, packet)->status = WAITING;
+    packet_queue_put(table, &queue, packet);
+  }
+
+  resident = resident_bytes() - resident;
+  table_bytes = (long int) table->chunk_count * PACKET_CHUNK_SIZE *
+    sizeof(Packet) + (long int) table->chunk_capacity * sizeof(Packet *) +
+    (long int) sizeof(Packet_Table);
+
+  printf("sizeof(Packet) = %d, %ld packets queued\n", (int) sizeof(Packet),
+	 (long int) packet_queue_size(&queue));
+  printf("table bytes/packet = %.3f, resident bytes/packet = %.3f\n",
+	 (double) table_bytes / packets, (double) resident / packets);
+
+  packet_table_free(table);
+  return 0;
+}
+
+#ifdef PACKET_MEMORY_BENCH_NO_ARGS
+
+int
+main(void)
+{
+  return packet_memory_bench(PACKET_MEMORY_BENCH_PACKETS);
+}
+
+#else
+
+int
+main(int argc, char ** argv)
+{
+  long int packets;
+
+  packets = argc > 1 ? atol(argv[1]) : PACKET_MEMORY_BENCH_PACKETS;
+  if (packets < 1) {
+    printf("Usage: %s [packets]\n", argv[0]);
+    exit(1);
+  }
+  return packet_memory_bench(packets);
+}
+
+#endif
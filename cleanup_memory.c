@@ -25,36 +25,34 @@
 
 #include "simlib.h"
 #include "main.h"
+#include "packet_table.h"
 #include "cleanup_memory.h"
 
 /******************************************************************************/
 
 /*
- * When a simulation_run run is finished, this function cleans up the memory
- * that has been allocated.
+ * When all the runs are finished, this function cleans up the memory that has
+ * been allocated.
  */
 
 void
 cleanup_memory (Simulation_Run_Ptr simulation_run)
 {
   Simulation_Run_Data_Ptr data;
-  Fifoqueue_Ptr buffer;
-  Server_Ptr link;
 
   data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-  buffer = data->buffer;
-  link = data->link;
 
-  if(link->state == BUSY) /* Clean out the server. */
-    xfree(server_get(link));
-  xfree(link);
+  /*
+   * Every packet, whether queued, in service or attached to a pending event,
+   * lives in the packet table, so freeing it frees them all.
+   */
 
-  while (fifoqueue_size(buffer) > 0) /* Clean out the queue. */
-    xfree(fifoqueue_get(buffer));
-  xfree(buffer);
+  packet_table_free(data->packets);
+
+  /*
+   * The links were allocated from the simulation_run arena, so releasing it
+   * frees them along with everything simlib allocated for the run.
+   */
 
   simulation_run_free_memory(simulation_run); /* Clean up the simulation_run. */
 }
-
-
-
@@ -0,0 +1,498 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+#include "simlib.h"
+#include "simparameters.h"
+#include "config.h"
+
+/******************************************************************************/
+
+/*
+ * The largest number of values a list or range may expand to.
+ */
+
+#define CONFIG_MAX_LIST 100000
+
+#define CONFIG_MAX_LINE 1024
+
+/*
+ * Settings are applied in two passes, the presets first and then everything
+ * else, so that a preset never overrides an explicit setting.
+ */
+
+#define PRESET_PASS 0
+#define SETTING_PASS 1
+
+/******************************************************************************/
+
+static void
+usage(const char * program)
+{
+  printf("Usage: %s [-c file] [--key=value] ...\n", program);
+  printf("Keys: packet_arrival_rate, packet_arrival_rate_sw2, "
+	 "packet_arrival_rate_sw3,\n");
+  printf("      packet_xmt_time, packet_xmt_time_sw2, packet_xmt_time_sw3,\n");
+  printf("      p12_cutoff, runlength, random_seed_list, fast_run, "
+	 "d_d_1_system,\n");
+  printf("      threads, lockstep, scaling_report, worker_report\n");
+  printf("Lists are comma separated values and start:stop:step ranges.\n");
+}
+
+static void
+bad_value(const char * where, const char * key, const char * value)
+{
+  printf("Error: %s: bad value \"%s\" for %s.\n", where, value, key);
+  exit(1);
+}
+
+/*
+ * Parse a whole string, less surrounding blanks, as a number. Returns 0 if it
+ * is not one.
+ */
+
+static int
+parse_number(const char * text, double * number)
+{
+  char * end;
+
+  *number = strtod(text, &end);
+  if (end == text)
+    return 0;
+  while (isspace((unsigned char) *end))
+    end++;
+  return *end == '\0' && isfinite(*number);
+}
+
+static void
+value_list_set(Value_List * list, const double * values, int count)
+{
+  if (list->values != NULL)
+    xfree(list->values);
+  list->values = (double *) xmalloc(count * sizeof(double));
+  memcpy(list->values, values, count * sizeof(double));
+  list->count = count;
+}
+
+/*
+ * Parse a list of values and start:stop:step ranges into list, replacing what
+ * it held.
+ */
+
+static void
+parse_list(Value_List * list, const char * where, const char * key,
+	   const char * value)
+{
+  char text[CONFIG_MAX_LINE];
+  char * item, * next, * colon;
+  double part[3];
+  double * values = NULL;
+  int count = 0, parts, n, k;
+
+  if (strlen(value) >= sizeof(text))
+    bad_value(where, key, value);
+  strcpy(text, value);
+
+  for (item = text; item != NULL; item = next) {
+    next = strchr(item, ',');
+    if (next != NULL)
+      *next++ = '\0';
+
+    for (parts = 0; ; parts++) {
+      colon = strchr(item, ':');
+      if (colon != NULL)
+	*colon = '\0';
+      if (parts == 3 || !parse_number(item, &part[parts]))
+	bad_value(where, key, value);
+      if (colon == NULL)
+	break;
+      item = colon + 1;
+    }
+
+    if (parts == 0) {
+      n = 1;
+    } else if (parts == 2 && part[2] != 0 &&
+	       (part[1] - part[0]) / part[2] > -1e-9 &&
+	       (part[1] - part[0]) / part[2] < CONFIG_MAX_LIST) {
+
+      /*
+       * The small allowance keeps stop in the range when (stop-start)/step
+       * comes out just below a whole number.
+       */
+
+      n = (int) floor((part[1] - part[0]) / part[2] + 1e-9) + 1;
+    } else {
+      bad_value(where, key, value);
+    }
+
+    if (count + n > CONFIG_MAX_LIST)
+      bad_value(where, key, value);
+    values = (double *) xrealloc(values, (count + n) * sizeof(double));
+    for (k = 0; k < n; k++)
+      values[count++] = part[0] + k * (parts == 0 ? 0 : part[2]);
+  }
+
+  value_list_set(list, values, count);
+  xfree(values);
+}
+
+/*
+ * Apply one setting. In PRESET_PASS only the presets are applied, and in
+ * SETTING_PASS only the rest.
+ */
+
+static void
+config_set(Config_Ptr config, const char * where, const char * key,
+	   const char * value, int pass)
+{
+  static const char * arrival_keys[] =
+    {"packet_arrival_rate", "packet_arrival_rate_sw2",
+     "packet_arrival_rate_sw3"};
+  static const char * xmt_keys[] =
+    {"packet_xmt_time", "packet_xmt_time_sw2", "packet_xmt_time_sw3"};
+  static const double fast_run_p12_cutoff[] = {FAST_RUN_P12_CUTOFF};
+  static const double fast_run_seeds[] = {FAST_RUN_RANDOM_SEED_LIST};
+  double number;
+  int i, k;
+
+  if (strcmp(key, "fast_run") == 0 || strcmp(key, "d_d_1_system") == 0) {
+    if (!parse_number(value, &number) || (number != 0 && number != 1))
+      bad_value(where, key, value);
+    if (pass != PRESET_PASS)
+      return;
+
+    if (strcmp(key, "fast_run") == 0) {
+      if (number == 1) {
+	value_list_set(&config->p12_cutoff, fast_run_p12_cutoff,
+		       sizeof(fast_run_p12_cutoff)/sizeof(double));
+	value_list_set(&config->random_seed_list, fast_run_seeds,
+		       sizeof(fast_run_seeds)/sizeof(double));
+	config->runlength = FAST_RUN_RUNLENGTH;
+      }
+    } else {
+      config->d_d_1_system = (int) number;
+      if (number == 1) {
+	config->packet_xmt_time[0] = D_D_1_PACKET_XMT_TIME;
+	config->packet_xmt_time[1] = D_D_1_PACKET_XMT_TIME_SW2;
+	config->packet_xmt_time[2] = D_D_1_PACKET_XMT_TIME_SW3;
+      }
+    }
+    return;
+  }
+
+  for (i = 0; i < 3; i++) {
+    if (strcmp(key, arrival_keys[i]) == 0) {
+      if (pass != SETTING_PASS)
+	return;
+      parse_list(&config->packet_arrival_rate[i], where, key, value);
+      for (k = 0; k < config->packet_arrival_rate[i].count; k++)
+	if (config->packet_arrival_rate[i].values[k] < 0)
+	  bad_value(where, key, value);
+      return;
+    }
+    if (strcmp(key, xmt_keys[i]) == 0) {
+      if (!parse_number(value, &number) || number <= 0)
+	bad_value(where, key, value);
+      if (pass == SETTING_PASS)
+	config->packet_xmt_time[i] = number;
+      return;
+    }
+  }
+
+  if (strcmp(key, "p12_cutoff") == 0) {
+    if (pass != SETTING_PASS)
+      return;
+    parse_list(&config->p12_cutoff, where, key, value);
+    for (k = 0; k < config->p12_cutoff.count; k++)
+      if (config->p12_cutoff.values[k] < 0 || config->p12_cutoff.values[k] > 1)
+	bad_value(where, key, value);
+  } else if (strcmp(key, "random_seed_list") == 0) {
+    if (pass != SETTING_PASS)
+      return;
+    parse_list(&config->random_seed_list, where, key, value);
+    for (k = 0; k < config->random_seed_list.count; k++) {
+      number = config->random_seed_list.values[k];
+      if (number < 1 || number > UINT_MAX || number != floor(number))
+	bad_value(where, key, value);
+    }
+  } else if (strcmp(key, "threads") == 0) {
+    if (!parse_number(value, &number) || number < 0 || number > 1024 ||
+	number != floor(number))
+      bad_value(where, key, value);
+    if (pass == SETTING_PASS)
+      config->threads = (int) number;
+  } else if (strcmp(key, "lockstep") == 0) {
+    if (!parse_number(value, &number) || number < 0 ||
+	number > LOCKSTEP_MAX_LANES || number != floor(number))
+      bad_value(where, key, value);
+    if (pass == SETTING_PASS)
+      config->lockstep = (int) number;
+  } else if (strcmp(key, "scaling_report") == 0 ||
+	     strcmp(key, "worker_report") == 0) {
+    if (!parse_number(value, &number) || (number != 0 && number != 1))
+      bad_value(where, key, value);
+    if (pass == SETTING_PASS && strcmp(key, "scaling_report") == 0)
+      config->scaling_report = (int) number;
+    else if (pass == SETTING_PASS)
+      config->worker_report = (int) number;
+  } else if (strcmp(key, "runlength") == 0) {
+    if (!parse_number(value, &number) || number < 1 || number > LONG_MAX ||
+	number != floor(number))
+      bad_value(where, key, value);
+    if (pass == SETTING_PASS)
+      config->runlength = (long int) number;
+  } else {
+    printf("Error: %s: unknown setting \"%s\".\n", where, key);
+    exit(1);
+  }
+}
+
+/*
+ * Apply the settings in a config file.
+ */
+
+static void
+config_read_file(Config_Ptr config, const char * file_name, int pass)
+{
+  char line[CONFIG_MAX_LINE];
+  char where[CONFIG_MAX_LINE + 32];
+  char * key, * value, * end;
+  int line_number = 0;
+  FILE * fp;
+
+  fp = fopen(file_name, "r");
+  if (fp == NULL) {
+    printf("Error: Cannot open config file \"%s\".\n", file_name);
+    exit(1);
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    line_number++;
+    snprintf(where, sizeof(where), "%s:%d", file_name, line_number);
+
+    if ((end = strchr(line, '#')) != NULL)
+      *end = '\0';
+
+    key = line;
+    while (isspace((unsigned char) *key))
+      key++;
+    if (*key == '\0')
+      continue;
+
+    value = strchr(key, '=');
+    if (value == NULL) {
+      printf("Error: %s: expected \"key = value\".\n", where);
+      exit(1);
+    }
+
+    for (end = value; end > key && isspace((unsigned char) end[-1]); end--)
+      ;
+    *end = '\0';
+    value++;
+    while (isspace((unsigned char) *value))
+      value++;
+
+    config_set(config, where, key, value, pass);
+  }
+
+  fclose(fp);
+}
+
+/******************************************************************************/
+
+/*
+ * Set the configuration to the defaults in simparameters.h.
+ */
+
+void
+config_init(Config_Ptr config)
+{
+  static const double p12_cutoff[] = {P12_CUTOFF};
+  static const double random_seeds[] = {RANDOM_SEED_LIST};
+  const double arrival_rates[3] =
+    {PACKET_ARRIVAL_RATE, PACKET_ARRIVAL_RATE_SW2, PACKET_ARRIVAL_RATE_SW3};
+  int i;
+
+  memset(config, 0, sizeof(Config));
+
+  for (i = 0; i < 3; i++)
+    value_list_set(&config->packet_arrival_rate[i], &arrival_rates[i], 1);
+
+  config->packet_xmt_time[0] = PACKET_XMT_TIME;
+  config->packet_xmt_time[1] = PACKET_XMT_TIME_SW2;
+  config->packet_xmt_time[2] = PACKET_XMT_TIME_SW3;
+
+  value_list_set(&config->p12_cutoff, p12_cutoff,
+		 sizeof(p12_cutoff)/sizeof(double));
+  value_list_set(&config->random_seed_list, random_seeds,
+		 sizeof(random_seeds)/sizeof(double));
+
+  config->runlength = RUNLENGTH;
+  config->blip_rate = (double) config->runlength/1000;
+  config->threads = 1;
+  config->lockstep = 0;
+
+#ifdef D_D_1_system
+  config->d_d_1_system = 1;
+#endif
+}
+
+/*
+ * Apply the config files and flags on the command line to a configuration set
+ * up by config_init(). The program stops with an error message if any of them
+ * is wrong.
+ */
+
+void
+config_load(Config_Ptr config, int argc, char ** argv)
+{
+  char key[CONFIG_MAX_LINE];
+  const char * arg, * value, * equals;
+  int pass, i;
+
+  for (pass = PRESET_PASS; pass <= SETTING_PASS; pass++) {
+    for (i = 1; i < argc; i++) {
+      arg = argv[i];
+
+      if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+	usage(argv[0]);
+	exit(0);
+      }
+
+      if (strcmp(arg, "-c") == 0 || strcmp(arg, "--config") == 0) {
+	if (++i == argc) {
+	  printf("Error: %s needs a file name.\n", arg);
+	  exit(1);
+	}
+	config_read_file(config, argv[i], pass);
+	continue;
+      }
+
+      if (strncmp(arg, "--config=", 9) == 0) {
+	config_read_file(config, arg + 9, pass);
+	continue;
+      }
+
+      if (strncmp(arg, "--", 2) != 0 || strlen(arg) >= sizeof(key)) {
+	printf("Error: Unknown argument \"%s\".\n", arg);
+	usage(argv[0]);
+	exit(1);
+      }
+
+      /*
+       * --key=value, --key value, or --key alone for a preset.
+       */
+
+      strcpy(key, arg + 2);
+      if ((equals = strchr(arg, '=')) != NULL) {
+	key[equals - arg - 2] = '\0';
+	value = equals + 1;
+      } else if (i + 1 < argc && argv[i+1][0] != '-') {
+	value = argv[++i];
+      } else if (strcmp(key, "fast_run") == 0 ||
+		 strcmp(key, "d_d_1_system") == 0 ||
+		 strcmp(key, "scaling_report") == 0 ||
+		 strcmp(key, "worker_report") == 0) {
+	value = "1";
+      } else {
+	printf("Error: %s needs a value.\n", arg);
+	exit(1);
+      }
+
+      config_set(config, "command line", key, value, pass);
+    }
+  }
+
+  config->blip_rate = (double) config->runlength/1000;
+
+  if (config->threads == 0) {
+    config->threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (config->threads < 1)
+      config->threads = 1;
+  }
+}
+
+/*
+ * The number of sweep points.
+ */
+
+long int
+config_sweep_count(Config_Ptr config)
+{
+  long int count;
+  int s;
+
+  count = config->p12_cutoff.count;
+  for (s = 0; s < 3; s++)
+    count *= config->packet_arrival_rate[s].count;
+  return count;
+}
+
+/*
+ * Get the arrival rates of SW1, SW2 and SW3 and the p12_cutoff of a sweep
+ * point. Returns the index of its p12_cutoff in the list.
+ */
+
+int
+config_sweep_point(Config_Ptr config, long int sweep,
+		   double * packet_arrival_rate, double * p12_cutoff)
+{
+  Value_List * rates;
+  long int k;
+  int i, s;
+
+  i = sweep % config->p12_cutoff.count;
+  k = sweep / config->p12_cutoff.count;
+  for (s = 2; s >= 0; s--) {
+    rates = &config->packet_arrival_rate[s];
+    packet_arrival_rate[s] = rates->values[k % rates->count];
+    k /= rates->count;
+  }
+  *p12_cutoff = config->p12_cutoff.values[i];
+  return i;
+}
+
+/*
+ * Free the value lists of a configuration.
+ */
+
+void
+config_free(Config_Ptr config)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+    xfree(config->packet_arrival_rate[i].values);
+  xfree(config->p12_cutoff.values);
+  xfree(config->random_seed_list.values);
+}
+
@@ -0,0 +1,116 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+/******************************************************************************/
+
+/*
+ * The run time configuration. It starts from the defaults in simparameters.h,
+ * then takes settings from config files and command line flags, in the order
+ * they are given:
+ *
+ *   simulation [-c file] [--key=value] ...
+ *
+ * A config file holds one "key = value" setting per line. Blank lines and
+ * anything after a '#' are ignored. A command line flag "--key=value" (or
+ * "--key value") sets the same keys. "--fast_run", "--d_d_1_system",
+ * "--scaling_report" and "--worker_report" alone set them to 1.
+ *
+ *   packet_arrival_rate       SW1 arrival rate list (packets/second)
+ *   packet_arrival_rate_sw2   SW2 arrival rate list
+ *   packet_arrival_rate_sw3   SW3 arrival rate list
+ *   packet_xmt_time           SW1 link transmission time (seconds)
+ *   packet_xmt_time_sw2       SW2 link transmission time
+ *   packet_xmt_time_sw3       SW3 link transmission time
+ *   p12_cutoff                list of SW1 to SW2 routing probabilities
+ *   runlength                 packets from SW1 delivered per run
+ *   random_seed_list          list of random number generator seeds
+ *   fast_run                  1 selects the FAST_RUN preset
+ *   d_d_1_system              1 selects the D/D/1 preset
+ *   threads                   replications run at once (0 for one per CPU)
+ *   lockstep                  seeds run side by side by the lockstep engine
+ *                             (2 to 16, 0 or 1 for the event engine)
+ *   scaling_report            1 times the sweep on 1 to threads threads
+ *   worker_report             1 prints the utilization of each worker
+ *
+ * A list is a comma separated list of values and ranges. A range
+ * "start:stop:step" stands for start, start+step, ... up to and including
+ * stop. For example "0.3:0.5:0.1, 0.65" is 0.3, 0.4, 0.5, 0.65. The presets
+ * are applied before any other setting, so an explicit setting always wins.
+ *
+ * main.c sweeps over every combination of the arrival rates and p12_cutoff,
+ * and runs each one with every seed. Sweep points are numbered from 0 with
+ * p12_cutoff varying fastest, then the SW3, SW2 and SW1 arrival rates. The
+ * simulation itself only reads the fields below.
+ */
+
+typedef struct _value_list_
+{
+  int count;
+  double * values;
+} Value_List;
+
+typedef struct _config_
+{
+  Value_List packet_arrival_rate[3];
+  double packet_xmt_time[3];
+  Value_List p12_cutoff;
+  Value_List random_seed_list;
+  long int runlength;
+  double blip_rate;
+  int d_d_1_system;
+  int threads;
+  int lockstep;
+  int scaling_report;
+  int worker_report;
+} Config, * Config_Ptr;
+
+/******************************************************************************/
+
+/*
+ * Function prototypes
+ */
+
+void
+config_init(Config_Ptr);
+
+void
+config_load(Config_Ptr, int, char **);
+
+long int
+config_sweep_count(Config_Ptr);
+
+int
+config_sweep_point(Config_Ptr, long int, double *, double *);
+
+void
+config_free(Config_Ptr);
+
+/******************************************************************************/
+
+#endif /* config.h */
+
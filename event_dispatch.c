@@ -0,0 +1,90 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+#include "packet_table.h"
+#include "packet_arrival.h"
+#include "packet_transmission.h"
+#include "event_dispatch.h"
+
+/******************************************************************************/
+
+/*
+ * Execute events that were scheduled by kind (see TYPED_EVENT_DISPATCH in
+ * simparameters.h) until there are none left or the predicate returns
+ * nonzero. The predicate is checked before every event, as it is by
+ * simulation_run_run_until. Each kind is executed with a direct call to its
+ * event function.
+ */
+
+Simulation_Run_Stop_Reason
+run_events_by_kind(Simulation_Run_Ptr simulation_run,
+		   Simulation_Run_Predicate predicate, void * ctx)
+{
+  Simulation_Run_Data_Ptr data;
+  uint32_t payload;
+  int kind;
+
+  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+
+  for (;;) {
+
+    if ((*predicate)(simulation_run, ctx))
+      return SIMULATION_RUN_STOP_PREDICATE;
+
+    kind = simulation_run_next_event(simulation_run, &payload);
+
+    switch (kind) {
+
+    case PACKET_ARRIVAL_EVENT:
+      packet_arrival_event(simulation_run, (void *) &data->switches[payload]);
+      break;
+
+    case FORWARDED_PACKET_ARRIVAL_EVENT:
+      forwarded_packet_arrival_event(simulation_run,
+				     PACKET_INDEX_TO_VOID(payload));
+      break;
+
+    case END_PACKET_TRANSMISSION_EVENT:
+      end_packet_transmission_event(simulation_run,
+				    (void *) &data->switches[payload]);
+      break;
+
+    case EVENT_KIND_FUNCTION:
+      break;
+
+    case EVENT_KIND_NONE:
+      return SIMULATION_RUN_STOP_NO_EVENTS;
+
+    default:
+      printf("Error: Unknown event kind %d.\n", kind);
+      exit(1);
+    }
+  }
+}
+
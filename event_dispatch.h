@@ -0,0 +1,44 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+#ifndef _EVENT_DISPATCH_H_
+#define _EVENT_DISPATCH_H_
+
+/******************************************************************************/
+
+#include "main.h"
+
+/******************************************************************************/
+
+/*
+ * Function prototypes
+ */
+
+Simulation_Run_Stop_Reason
+run_events_by_kind(Simulation_Run_Ptr, Simulation_Run_Predicate, void *);
+
+/******************************************************************************/
+
+#endif /* event_dispatch.h */
+
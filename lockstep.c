@@ -0,0 +1,496 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "simlib.h"
+#include "main.h"
+#include "routing.h"
+#include "lockstep.h"
+
+/******************************************************************************/
+
+/*
+ * The time of an empty slot.
+ */
+
+#ifdef SIMLIB_TICK_CLOCK
+#define LOCKSTEP_NEVER ((Sim_Time) UINT64_MAX)
+#else
+#define LOCKSTEP_NEVER HUGE_VAL
+#endif
+
+#define LOCKSTEP_ARRIVAL_SLOT(ls, s) (s)
+#define LOCKSTEP_END_SLOT(ls, s) ((ls)->switch_count + (s))
+#define LOCKSTEP_FORWARD_SLOT(ls, s) (2 * (ls)->switch_count + (s))
+
+/*
+ * The slot picking kernel compares the slot times as doubles, so it is only
+ * used with the default double clock.
+ */
+
+#if defined(__AVX2__) && !defined(SIMLIB_TICK_CLOCK)
+#define LOCKSTEP_AVX2_SELECT
+#endif
+
+/******************************************************************************/
+
+static void
+lockstep_queue_put(Lockstep_Queue * queue, Lockstep_Packet packet)
+{
+  Lockstep_Packet * packets;
+  int i;
+
+  if (queue->size == queue->capacity) {
+    packets = (Lockstep_Packet *) xmalloc((queue->capacity == 0 ? 64 :
+					    2 * queue->capacity) *
+					   sizeof(Lockstep_Packet));
+    for (i = 0; i < queue->size; i++)
+      packets[i] = queue->packets[(queue->head + i) % queue->capacity];
+    if (queue->packets != NULL)
+      xfree(queue->packets);
+    queue->packets = packets;
+    queue->capacity = queue->capacity == 0 ? 64 : 2 * queue->capacity;
+    queue->head = 0;
+  }
+
+  queue->packets[(queue->head + queue->size) % queue->capacity] = packet;
+  queue->size++;
+}
+
+static Lockstep_Packet
+lockstep_queue_get(Lockstep_Queue * queue)
+{
+  Lockstep_Packet packet;
+
+  packet = queue->packets[queue->head];
+  queue->head = (queue->head + 1) % queue->capacity;
+  queue->size--;
+  return packet;
+}
+
+/*
+ * Put an event in a slot of a lane, giving it the lane's next event id.
+ */
+
+static inline void
+lockstep_schedule(Lockstep_Ptr ls, int slot, int lane, Sim_Time time)
+{
+  ls->slot_time[slot][lane] = time;
+  ls->slot_id[slot][lane] = ls->next_event_id[lane]++;
+}
+
+/*
+ * Start the transmission of a packet on the link of switch s, as
+ * start_transmission_on_link() does.
+ */
+
+static inline void
+lockstep_start_transmission(Lockstep_Ptr ls, Simulation_Run_Data_Ptr data,
+			    int s, int lane, Lockstep_Packet packet)
+{
+  ls->link_busy[s][lane] = 1;
+  ls->in_service[s][lane] = packet;
+  lockstep_schedule(ls, LOCKSTEP_END_SLOT(ls, s), lane,
+		    ls->now[lane] + data->switches[s].xmt_time);
+}
+
+/******************************************************************************/
+
+/*
+ * Kernels. Each works on all LOCKSTEP_MAX_LANES lanes. The lanes that are not
+ * in use have only empty slots, and do not draw or deliver packets.
+ */
+
+/*
+ * Find the earliest slot of each lane. Slots are ordered by time and then by
+ * event id, as simlib orders its events.
+ */
+
+static void
+lockstep_select(Lockstep_Ptr ls)
+{
+  int k, l;
+
+#ifdef LOCKSTEP_AVX2_SELECT
+  __m256d time, best_time, earlier, same;
+  __m256i id, best_id, best_slot, lower, better;
+  int64_t slots[4];
+
+  for (l = 0; l < LOCKSTEP_MAX_LANES; l += 4) {
+    best_time = _mm256_loadu_pd(&ls->slot_time[0][l]);
+    best_id = _mm256_loadu_si256((__m256i *) &ls->slot_id[0][l]);
+    best_slot = _mm256_setzero_si256();
+
+    for (k = 1; k < ls->slot_count; k++) {
+      time = _mm256_loadu_pd(&ls->slot_time[k][l]);
+      id = _mm256_loadu_si256((__m256i *) &ls->slot_id[k][l]);
+      earlier = _mm256_cmp_pd(time, best_time, _CMP_LT_OQ);
+      same = _mm256_cmp_pd(time, best_time, _CMP_EQ_OQ);
+      lower = _mm256_cmpgt_epi64(best_id, id);
+      better = _mm256_or_si256(_mm256_castpd_si256(earlier),
+			       _mm256_and_si256(_mm256_castpd_si256(same),
+						lower));
+      best_time = _mm256_blendv_pd(best_time, time,
+				   _mm256_castsi256_pd(better));
+      best_id = _mm256_blendv_epi8(best_id, id, better);
+      best_slot = _mm256_blendv_epi8(best_slot, _mm256_set1_epi64x(k),
+				     better);
+    }
+
+    _mm256_storeu_si256((__m256i *) slots, best_slot);
+    for (k = 0; k < 4; k++)
+      ls->slot[l + k] = (int) slots[k];
+  }
+#else
+  Sim_Time best_time[LOCKSTEP_MAX_LANES];
+  int64_t best_id[LOCKSTEP_MAX_LANES];
+
+  for (l = 0; l < LOCKSTEP_MAX_LANES; l++) {
+    best_time[l] = ls->slot_time[0][l];
+    best_id[l] = ls->slot_id[0][l];
+    ls->slot[l] = 0;
+  }
+
+  for (k = 1; k < ls->slot_count; k++)
+    for (l = 0; l < LOCKSTEP_MAX_LANES; l++)
+      if (ls->slot_time[k][l] < best_time[l] ||
+	  (ls->slot_time[k][l] == best_time[l] &&
+	   ls->slot_id[k][l] < best_id[l])) {
+	best_time[l] = ls->slot_time[k][l];
+	best_id[l] = ls->slot_id[k][l];
+	ls->slot[l] = k;
+      }
+#endif
+}
+
+/*
+ * Draw a uniform random number in (0, 1) for each lane with draw set, from
+ * the lane's copy of the Rand_Stream generator. As in
+ * rand_stream_uniform_generator(), a draw of 0 is rejected and drawn again.
+ */
+
+static void
+lockstep_draw(Lockstep_Ptr ls)
+{
+  int l;
+
+#ifdef __AVX2__
+  const __m256i a = _mm256_set1_epi32(RAND_STREAM_A);
+  const __m256i c = _mm256_set1_epi32(RAND_STREAM_C);
+  const __m256i max = _mm256_set1_epi32(RAND_STREAM_MAX);
+  const __m256i below_max = _mm256_set1_epi32(RAND_STREAM_MAX - 1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256d scale = _mm256_set1_pd((double) RAND_STREAM_MAX);
+  __m256i pending, next, stepped, r, value;
+
+  for (l = 0; l < LOCKSTEP_MAX_LANES; l += 8) {
+    pending = _mm256_sub_epi32(zero,
+			       _mm256_loadu_si256((__m256i *) &ls->draw[l]));
+    next = _mm256_loadu_si256((__m256i *) &ls->rand_next[l]);
+    value = zero;
+
+    while (!_mm256_testz_si256(pending, pending)) {
+      stepped = _mm256_add_epi32(_mm256_mullo_epi32(next, a), c);
+      next = _mm256_blendv_epi8(next, stepped, pending);
+
+      /* (next >> 16) % RAND_STREAM_MAX, for values below 2^16. */
+      r = _mm256_srli_epi32(stepped, 16);
+      r = _mm256_sub_epi32(r, _mm256_and_si256(_mm256_cmpgt_epi32(r, below_max),
+					       max));
+      r = _mm256_sub_epi32(r, _mm256_and_si256(_mm256_cmpgt_epi32(r, below_max),
+					       max));
+
+      value = _mm256_blendv_epi8(value, r, pending);
+      pending = _mm256_and_si256(pending, _mm256_cmpeq_epi32(r, zero));
+    }
+
+    _mm256_storeu_si256((__m256i *) &ls->rand_next[l], next);
+    _mm256_storeu_pd(&ls->uniform[l],
+		     _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(value)),
+				   scale));
+    _mm256_storeu_pd(&ls->uniform[l + 4],
+		     _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(value, 1)),
+				   scale));
+  }
+#else
+  unsigned r;
+
+  for (l = 0; l < LOCKSTEP_MAX_LANES; l++)
+    if (ls->draw[l]) {
+      do {
+	ls->rand_next[l] = ls->rand_next[l] * RAND_STREAM_A + RAND_STREAM_C;
+	r = (ls->rand_next[l] >> 16) % RAND_STREAM_MAX;
+      } while (r == 0);
+      ls->uniform[l] = (double) r / (double) RAND_STREAM_MAX;
+    }
+#endif
+}
+
+/*
+ * Count the packets that left the network in this step against the switch
+ * they came from, and add up their delays. Adding 0 for the other lanes
+ * leaves their totals unchanged, so the loop has no branches and the compiler
+ * can vectorize it.
+ */
+
+static void
+lockstep_accumulate(Lockstep_Ptr ls)
+{
+  int s, l, hit;
+
+  for (s = 0; s < ls->switch_count; s++)
+    for (l = 0; l < LOCKSTEP_MAX_LANES; l++) {
+      hit = ls->exit_source[l] == s;
+      ls->accumulated_delay[s][l] += hit ? ls->exit_delay[l] : 0.0;
+      ls->number_of_packets_processed[s][l] += hit;
+    }
+}
+
+/******************************************************************************/
+
+/*
+ * Run the event in slot of a lane. These do what packet_arrival_event(),
+ * end_packet_transmission_event() and forwarded_packet_arrival_event() do.
+ */
+
+static void
+lockstep_event(Lockstep_Ptr ls, Simulation_Run_Data_Ptr data, int slot,
+	       int lane)
+{
+  Lockstep_Packet packet;
+  Switch_Ptr sw;
+  Sim_Time now = ls->now[lane];
+  double rate;
+  int s, to;
+
+  s = slot % ls->switch_count;
+  sw = &data->switches[s];
+
+  if (slot == LOCKSTEP_ARRIVAL_SLOT(ls, s)) {
+
+    ls->arrival_count[s][lane]++;
+    packet.arrive_time = now;
+    packet.source_id = s;
+
+    if (ls->link_busy[s][lane])
+      lockstep_queue_put(&ls->buffer[s][lane], packet);
+    else
+      lockstep_start_transmission(ls, data, s, lane, packet);
+
+    rate = sw->config->packet_arrival_rate;
+    if (data->config->d_d_1_system)
+      lockstep_schedule(ls, slot, lane,
+			now + SIM_TIME_FROM_SECONDS((double) 1/rate));
+    else
+      lockstep_schedule(ls, slot, lane,
+			now + SIM_TIME_FROM_SECONDS(-1.0 * log(ls->uniform[lane]) *
+						    ((double) 1/rate)));
+
+  } else if (slot == LOCKSTEP_END_SLOT(ls, s)) {
+
+    packet = ls->in_service[s][lane];
+    ls->link_busy[s][lane] = 0;
+
+    if (sw->config->next_hop_count > 0) {
+      to = sw->routing.count == 1 ? sw->routing.next_hop[0] :
+	routing_table_pick(&sw->routing, ls->uniform[lane]);
+      if (ls->slot_time[LOCKSTEP_FORWARD_SLOT(ls, s)][lane] != LOCKSTEP_NEVER) {
+	printf("Error: %s forwarded two packets at the same time.\n",
+	       sw->name);
+	exit(1);
+      }
+      ls->forwarded[s][lane] = packet;
+      ls->forwarded_to[s][lane] = to;
+      lockstep_schedule(ls, LOCKSTEP_FORWARD_SLOT(ls, s), lane, now);
+    } else {
+      ls->exit_source[lane] = packet.source_id;
+      ls->exit_delay[lane] = SIM_TIME_TO_SECONDS(now - packet.arrive_time);
+    }
+
+    if (ls->buffer[s][lane].size > 0)
+      lockstep_start_transmission(ls, data, s, lane,
+				  lockstep_queue_get(&ls->buffer[s][lane]));
+
+  } else {
+
+    packet = ls->forwarded[s][lane];
+    to = ls->forwarded_to[s][lane];
+
+    if (ls->link_busy[to][lane])
+      lockstep_queue_put(&ls->buffer[to][lane], packet);
+    else
+      lockstep_start_transmission(ls, data, to, lane, packet);
+  }
+}
+
+/******************************************************************************/
+
+Lockstep_Ptr
+lockstep_new(void)
+{
+  return (Lockstep_Ptr) xcalloc(1, sizeof(Lockstep));
+}
+
+void
+lockstep_free(Lockstep_Ptr ls)
+{
+  int s, l;
+
+  for (s = 0; s < MAX_SWITCHES; s++)
+    for (l = 0; l < LOCKSTEP_MAX_LANES; l++)
+      if (ls->buffer[s][l].packets != NULL)
+	xfree(ls->buffer[s][l].packets);
+  xfree(ls);
+}
+
+/*
+ * Run one replication of the sweep point set up in data for each of the lanes
+ * seeds, and return the totals of lane l in totals[l]. The switches in data
+ * must have been reset with switches_reset(). Each lane stops, as
+ * run_length_reached() stops the event engine, once SW1 has delivered
+ * runlength packets.
+ */
+
+void
+lockstep_run(Lockstep_Ptr ls, Simulation_Run_Data_Ptr data,
+	     const unsigned * seeds, int lanes, Switch_Totals ** totals)
+{
+  Switch_Ptr sw;
+  int k, s, l, running;
+
+  if (lanes < 1 || lanes > LOCKSTEP_MAX_LANES) {
+    printf("Error: The lockstep engine runs from 1 to %d lanes.\n",
+	   LOCKSTEP_MAX_LANES);
+    exit(1);
+  }
+
+  ls->lanes = lanes;
+  ls->switch_count = data->topology.switch_count;
+  ls->slot_count = 3 * ls->switch_count;
+
+  for (k = 0; k < LOCKSTEP_MAX_SLOTS; k++)
+    for (l = 0; l < LOCKSTEP_MAX_LANES; l++) {
+      ls->slot_time[k][l] = LOCKSTEP_NEVER;
+      ls->slot_id[k][l] = INT64_MAX;
+    }
+
+  for (l = 0; l < LOCKSTEP_MAX_LANES; l++) {
+    ls->now[l] = 0;
+    ls->next_event_id[l] = 1;
+    ls->active[l] = l < lanes;
+    ls->rand_next[l] = l < lanes ? seeds[l] : 0;
+    ls->draw[l] = 0;
+    ls->exit_source[l] = -1;
+    for (s = 0; s < MAX_SWITCHES; s++) {
+      ls->link_busy[s][l] = 0;
+      ls->buffer[s][l].head = 0;
+      ls->buffer[s][l].size = 0;
+      ls->arrival_count[s][l] = 0;
+      ls->number_of_packets_processed[s][l] = 0;
+      ls->accumulated_delay[s][l] = 0;
+    }
+  }
+
+  /*
+   * The first packet arrival at each switch with a source, at time 0.
+   */
+
+  for (l = 0; l < lanes; l++)
+    for (s = 0; s < ls->switch_count; s++)
+      if (data->switches[s].config->packet_arrival_rate > 0)
+	lockstep_schedule(ls, LOCKSTEP_ARRIVAL_SLOT(ls, s), l, 0);
+
+  for (;;) {
+
+    running = 0;
+    for (l = 0; l < lanes; l++) {
+      if (ls->active[l] &&
+	  ls->number_of_packets_processed[0][l] >= data->config->runlength)
+	ls->active[l] = 0;
+      running += ls->active[l];
+    }
+    if (running == 0)
+      break;
+
+    lockstep_select(ls);
+
+    /*
+     * Take each lane's event out of its slot, and see which lanes draw a
+     * random number: source arrivals, unless arrivals are deterministic,
+     * and the ends of transmissions on links with more than one next hop.
+     */
+
+    for (l = 0; l < lanes; l++) {
+      ls->draw[l] = 0;
+      ls->exit_source[l] = -1;
+      if (!ls->active[l])
+	continue;
+
+      k = ls->slot[l];
+      if (ls->slot_time[k][l] == LOCKSTEP_NEVER) {
+	ls->active[l] = 0;
+	continue;
+      }
+      ls->now[l] = ls->slot_time[k][l];
+      ls->slot_time[k][l] = LOCKSTEP_NEVER;
+      ls->slot_id[k][l] = INT64_MAX;
+
+      s = k % ls->switch_count;
+      sw = &data->switches[s];
+      if (k == LOCKSTEP_ARRIVAL_SLOT(ls, s))
+	ls->draw[l] = !data->config->d_d_1_system;
+      else if (k == LOCKSTEP_END_SLOT(ls, s))
+	ls->draw[l] = sw->config->next_hop_count > 0 && sw->routing.count > 1;
+    }
+
+    lockstep_draw(ls);
+
+    for (l = 0; l < lanes; l++)
+      if (ls->active[l])
+	lockstep_event(ls, data, ls->slot[l], l);
+
+    lockstep_accumulate(ls);
+  }
+
+  for (l = 0; l < lanes; l++)
+    for (s = 0; s < ls->switch_count; s++) {
+      totals[l][s].packet_arrival_rate =
+	data->switches[s].config->packet_arrival_rate;
+      totals[l][s].arrival_count = ls->arrival_count[s][l];
+      totals[l][s].number_of_packets_processed =
+	ls->number_of_packets_processed[s][l];
+      totals[l][s].accumulated_delay = ls->accumulated_delay[s][l];
+      totals[l][s].random_seed = seeds[l];
+    }
+}
+
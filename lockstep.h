@@ -0,0 +1,124 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _LOCKSTEP_H_
+#define _LOCKSTEP_H_
+
+/******************************************************************************/
+
+#include <stdint.h>
+#include "main.h"
+
+/******************************************************************************/
+
+/*
+ * The lockstep engine runs up to LOCKSTEP_MAX_LANES (see simparameters.h)
+ * replications of one sweep point, with different seeds, side by side. Each
+ * replication is a lane. The state of the lanes is kept as structure of
+ * arrays, indexed [switch][lane] or [slot][lane], so that each step can work
+ * on all the lanes at once.
+ *
+ * There is no event list. A lane has at most one pending event in each slot:
+ * the next source arrival at each switch, the end of the transmission on each
+ * link, and the arrival of the packet last forwarded by each switch. A step
+ * finds the earliest slot of every lane, ordered by time and then by event id
+ * as simlib orders its events. It then draws one uniform random number for
+ * every lane whose event needs one, runs the events, and adds up the delays
+ * of the packets that left the network. Each lane draws from its own copy of
+ * the Rand_Stream generator, so the lanes give the same results as the event
+ * engine with the same seeds. Nothing is traced or printed.
+ *
+ * When compiled with AVX2 (-mavx2), picking the next slot and the random
+ * number draws run as AVX2 kernels, with the lanes that are not drawing or
+ * have finished masked out. Otherwise they are plain loops over the lanes.
+ */
+
+#define LOCKSTEP_MAX_SLOTS (3 * MAX_SWITCHES)
+
+typedef struct _lockstep_packet_
+{
+  Sim_Time arrive_time;
+  int source_id;
+} Lockstep_Packet;
+
+typedef struct _lockstep_queue_
+{
+  Lockstep_Packet * packets;
+  int head;
+  int size;
+  int capacity;
+} Lockstep_Queue;
+
+typedef struct _lockstep_
+{
+  int lanes;
+  int switch_count;
+  int slot_count;
+
+  Sim_Time slot_time[LOCKSTEP_MAX_SLOTS][LOCKSTEP_MAX_LANES];
+  int64_t slot_id[LOCKSTEP_MAX_SLOTS][LOCKSTEP_MAX_LANES];
+
+  Sim_Time now[LOCKSTEP_MAX_LANES];
+  int64_t next_event_id[LOCKSTEP_MAX_LANES];
+  uint32_t rand_next[LOCKSTEP_MAX_LANES];
+  int32_t active[LOCKSTEP_MAX_LANES];
+
+  int slot[LOCKSTEP_MAX_LANES];
+  int32_t draw[LOCKSTEP_MAX_LANES];
+  double uniform[LOCKSTEP_MAX_LANES];
+  int exit_source[LOCKSTEP_MAX_LANES];
+  double exit_delay[LOCKSTEP_MAX_LANES];
+
+  int link_busy[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+  Lockstep_Packet in_service[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+  Lockstep_Packet forwarded[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+  int forwarded_to[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+  Lockstep_Queue buffer[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+
+  long int arrival_count[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+  long int number_of_packets_processed[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+  double accumulated_delay[MAX_SWITCHES][LOCKSTEP_MAX_LANES];
+} Lockstep, * Lockstep_Ptr;
+
+/******************************************************************************/
+
+/*
+ * Function prototypes
+ */
+
+Lockstep_Ptr
+lockstep_new(void);
+
+void
+lockstep_free(Lockstep_Ptr);
+
+void
+lockstep_run(Lockstep_Ptr, Simulation_Run_Data_Ptr, const unsigned *, int,
+	     Switch_Totals **);
+
+/******************************************************************************/
+
+#endif /* lockstep.h */
+
@@ -23,371 +23,231 @@
 
 /*******************************************************************************/
 
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
-#include "output.h"
+#include <time.h>
 #include "simparameters.h"
-#include "packet_arrival.h"
-#include "cleanup_memory.h"
+#include "config.h"
+#include "replication.h"
 #include "trace.h"
 #include "main.h"
 
 /******************************************************************************/
 
+#define CSV_FILE_NAME "./Q4.csv"
+
 /*
- * main.c declares and creates a new simulation_run with parameters defined in
- * simparameters.h. The code creates a fifo queue and server for the single
- * server queueuing system. It then loops through the list of random number
- * generator seeds defined in simparameters.h, doing a separate simulation_run
- * run for each. To start a run, it schedules the first packet arrival
- * event. When each run is finished, output is printed on the terminal.
+ * Called when all the replications of a sweep point have been committed. The
+ * averages over the seeds are printed and written to the csv file.
  */
 
-int
-main(void)
+static void
+sweep_point_done(Sweep_Totals * sweep, long int point, int switch_count)
 {
-  Simulation_Run_Ptr simulation_run;
-  Simulation_Run_Data data;
-
-  Simulation_Run_Data for_avg_acc;
-
-  /*
-   * Declare and initialize our random number generator seeds defined in
-   * simparameters.h
-   */
-
-  unsigned RANDOM_SEEDS[] = {RANDOM_SEED_LIST, 0};
-  double PACKET_ARRIVAL_RATE_LIST[] = {PACKET_ARRIVAL_RATE};
-  double P12_CUTOFF_LIST[] = {P12_CUTOFF};
-  unsigned random_seed;
-
-  int size_rand_seed = (sizeof(RANDOM_SEEDS)/sizeof(unsigned)) - 1;
-  printf("size_rand_seed = %d \n", size_rand_seed);
-
-  int j;
+  Config_Ptr config = sweep->config;
+  Switch_Totals * totals = sweep->switches;
+  int size_rand_seed = config->random_seed_list.count;
+  double packet_arrival_rate[3];
+  double p12_cutoff;
+  double xmtted_fraction;
+  int i, s;
+
+  i = config_sweep_point(config, point, packet_arrival_rate, &p12_cutoff);
+
+  for (s = 0; s < switch_count; s++) {
+    totals[s].packet_arrival_rate /= size_rand_seed;
+    totals[s].arrival_count /= size_rand_seed;
+    totals[s].number_of_packets_processed /= size_rand_seed;
+    totals[s].accumulated_delay /= size_rand_seed;
+    totals[s].random_seed /= size_rand_seed;
+  }
 
-  #ifndef NO_CSV_OUTPUT
-  // create a csv file
+#ifndef NO_CSV_OUTPUT
   FILE* fp;
-  char data_set_name[] = "./Q4.csv";
-  //file IO
 
-  fp = fopen(data_set_name, "w");
+  fp = fopen(CSV_FILE_NAME, "a");
   //cell/element name/type
 
-  fprintf(fp, ("Random Seed,"));
-  fprintf(fp, ("Packet arrival count,"));
-
-  fprintf(fp, ("Transmitted packet count ,"));
-  fprintf(fp, ("Service Fraction ,"));
-  fprintf(fp, ("Arrival rate,"));
-  fprintf(fp, ("Mean Delay (msec),"));
-//sw2
-  fprintf(fp, ("Random Seed,"));
-  fprintf(fp, ("Packet arrival count,"));
-
-  fprintf(fp, ("Transmitted packet count ,"));
-  fprintf(fp, ("Service Fraction ,"));
-  fprintf(fp, ("Arrival rate,"));
-  fprintf(fp, ("Mean Delay (msec),"));
-//sw3
-  fprintf(fp, ("Random Seed,"));
-  fprintf(fp, ("Packet arrival count,"));
-
-  fprintf(fp, ("Transmitted packet count ,"));
-  fprintf(fp, ("Service Fraction ,"));
-  fprintf(fp, ("Arrival rate,"));
-  fprintf(fp, ("Mean Delay (msec),"));
-  fprintf(fp, "\n");
-  fclose(fp);
-  #endif
+  for (s = 0; s < switch_count; s++) {
 
+    /*
+     * The first column holds the routing probability for SW1, whose routing
+     * is what is varied, and the loop index for the others.
+     */
 
-  for (int i = 0; i < (sizeof(P12_CUTOFF_LIST)/sizeof(double)); i ++)
-  {
-
-      j = 0;
-      random_seed = RANDOM_SEEDS[j];
-
-      for_avg_acc.packet_arrival_rate = 0;
-      for_avg_acc.blip_counter = 0;
-      for_avg_acc.arrival_count = 0;
-      for_avg_acc.number_of_packets_processed = 0;
-      for_avg_acc.accumulated_delay = 0;
-      for_avg_acc.random_seed = 0;
-
-      for_avg_acc.packet_arrival_rate_2 = 0;
-      for_avg_acc.blip_counter_2 = 0;
-      for_avg_acc.arrival_count_2 = 0;
-      for_avg_acc.number_of_packets_processed_2 = 0;
-      for_avg_acc.accumulated_delay_2 = 0;
-      for_avg_acc.random_seed_2 = 0;
-
-      for_avg_acc.packet_arrival_rate_3 = 0;
-      for_avg_acc.blip_counter_3 = 0;
-      for_avg_acc.arrival_count_3 = 0;
-      for_avg_acc.number_of_packets_processed_3 = 0;
-      for_avg_acc.accumulated_delay_3 = 0;
-      for_avg_acc.random_seed_3 = 0;
-
-      while (random_seed != 0) {
-     
-
-        simulation_run = simulation_run_new(); /* Create a new simulation run. */
-
-        /*
-         * Set the simulation_run data pointer to our data object.
-         */
-
-        simulation_run_attach_data(simulation_run, (void *) & data);
-
-        /* 
-         * Initialize the simulation_run data variables, declared in main.h.
-         */
-        data.p12_cutoff = P12_CUTOFF_LIST[i];
-        
-        data.packet_arrival_rate = PACKET_ARRIVAL_RATE;
-        data.blip_counter = 0;
-        data.arrival_count = 0;
-        data.number_of_packets_processed = 0;
-        data.accumulated_delay = 0.0;
-        data.random_seed = random_seed;
-     
-        data.packet_arrival_rate_2 = PACKET_ARRIVAL_RATE_SW2;
-        data.blip_counter_2 = 0;
-        data.arrival_count_2 = 0;
-        data.number_of_packets_processed_2 = 0;
-        data.accumulated_delay_2 = 0.0;
-        data.random_seed_2 = random_seed;
-
-        data.packet_arrival_rate_3 = PACKET_ARRIVAL_RATE_SW3;
-        data.blip_counter_3 = 0;
-        data.arrival_count_3 = 0;
-        data.number_of_packets_processed_3 = 0;
-        data.accumulated_delay_3 = 0.0;
-        data.random_seed_3 = random_seed;
-        /* 
-         * Create the packet buffer and transmission link, declared in main.h.
-         */
-
-        data.buffer = fifoqueue_new();
-        data.link   = server_new();
-
-        data.buffer_2 = fifoqueue_new();
-        data.link_2 = server_new();
-
-        data.buffer_3 = fifoqueue_new();
-        data.link_3 = server_new();
-        /* 
-         * Set the random number generator seed for this run.
-         */
-
-        random_generator_initialize(random_seed);
-
-        //clock_t prog_t = clock();
-        //printf("before schedule arrival event program time %f\n", prog_t);
-        /* 
-         * Schedule the initial packet arrival for the current clock time (= 0).
-         */
-
-        schedule_packet_arrival_event(simulation_run, simulation_run_get_time(simulation_run));
-        schedule_packet_arrival_event_sw2(simulation_run, simulation_run_get_time(simulation_run));
-        schedule_packet_arrival_event_sw3(simulation_run, simulation_run_get_time(simulation_run));
-
-        //printf("after schedule arrival event program time %f\n", clock());
-        /* 
-         * Execute events until we are finished. 
-         */
-
-        //while(data.number_of_packets_processed < RUNLENGTH) {
-        while(
-                data.number_of_packets_processed < RUNLENGTH &&
-//                data.number_of_packets_processed_2 < RUNLENGTH ||
-//                data.number_of_packets_processed_3 < RUNLENGTH || 
-                1 //dummy var to keep format
-                ) {
-          //printf("MM_debug while loop program time \n");
-          simulation_run_execute_event(simulation_run);
-        }
-
-        /*
-         * Output results and clean up after ourselves.
-         */
-
-        output_results(simulation_run);
-        output_results_sw2(simulation_run);
-        output_results_sw3(simulation_run);
-
-        for_avg_acc.packet_arrival_rate += data.packet_arrival_rate;
-        for_avg_acc.blip_counter += data.blip_counter;
-        for_avg_acc.arrival_count += data.arrival_count;
-        for_avg_acc.number_of_packets_processed += data.number_of_packets_processed;
-        for_avg_acc.accumulated_delay += data.accumulated_delay;
-        for_avg_acc.random_seed += data.random_seed;
-
-        for_avg_acc.packet_arrival_rate_2 += data.packet_arrival_rate_2;
-        for_avg_acc.blip_counter_2 += data.blip_counter_2;
-        for_avg_acc.arrival_count_2 += data.arrival_count_2;
-        for_avg_acc.number_of_packets_processed_2 += data.number_of_packets_processed_2;
-        for_avg_acc.accumulated_delay_2 += data.accumulated_delay_2;
-        for_avg_acc.random_seed_2 += data.random_seed_2;
-
-        for_avg_acc.packet_arrival_rate_3 += data.packet_arrival_rate_3;
-        for_avg_acc.blip_counter_3 += data.blip_counter_3;
-        for_avg_acc.arrival_count_3 += data.arrival_count_3;
-        for_avg_acc.number_of_packets_processed_3 += data.number_of_packets_processed_3;
-        for_avg_acc.accumulated_delay_3 += data.accumulated_delay_3;
-        for_avg_acc.random_seed_3 += data.random_seed_3;
-
-        cleanup_memory(simulation_run);
-
-        j++;
-        random_seed = RANDOM_SEEDS[j];
-      }
-
-      for_avg_acc.packet_arrival_rate /= size_rand_seed;
-      for_avg_acc.blip_counter /= size_rand_seed;
-      for_avg_acc.arrival_count /= size_rand_seed;
-      for_avg_acc.number_of_packets_processed /= size_rand_seed;
-      for_avg_acc.accumulated_delay /= size_rand_seed;
-      for_avg_acc.random_seed /= size_rand_seed;
-
-      for_avg_acc.packet_arrival_rate_2 /= size_rand_seed;
-      for_avg_acc.blip_counter_2 /= size_rand_seed;
-      for_avg_acc.arrival_count_2 /= size_rand_seed;
-      for_avg_acc.number_of_packets_processed_2 /= size_rand_seed;
-      for_avg_acc.accumulated_delay_2 /= size_rand_seed;
-      for_avg_acc.random_seed_2 /= size_rand_seed;
-
-      for_avg_acc.packet_arrival_rate_3 /= size_rand_seed;
-      for_avg_acc.blip_counter_3 /= size_rand_seed;
-      for_avg_acc.arrival_count_3 /= size_rand_seed;
-      for_avg_acc.number_of_packets_processed_3 /= size_rand_seed;
-      for_avg_acc.accumulated_delay_3 /= size_rand_seed;
-      for_avg_acc.random_seed_3 /= size_rand_seed;
-  #ifndef NO_CSV_OUTPUT
-      fp = fopen(data_set_name, "a");
-      //cell/element name/type
+    if (s == 0)
+      fprintf(fp, "%f,", p12_cutoff);
+    else
+      fprintf(fp, "%d,", i);
 
-      //fprintf(fp, ("loop,"));
-      fprintf(fp, "%f,", P12_CUTOFF_LIST[i]);
+    //fprintf(fp, ("Packet arrival count,"));
+    fprintf(fp, "%ld, ", totals[s].arrival_count);
 
-      //fprintf(fp, ("Packet arrival count,"));
-      fprintf(fp, "%ld, ", for_avg_acc.arrival_count);
+    //fprintf(fp, ("Transmitted packet count ,"));
+    fprintf(fp, "%ld,", totals[s].number_of_packets_processed);
 
-      //fprintf(fp, ("Transmitted packet count ,"));
-      fprintf(fp, "%ld,", for_avg_acc.number_of_packets_processed);
+    //fprintf(fp, ("Service Fraction ,"));
+    fprintf(fp, "%.5f,", (double) totals[s].number_of_packets_processed /totals[s].arrival_count);
 
-      //fprintf(fp, ("Service Fraction ,"));
-      fprintf(fp, "%.5f,", (double) for_avg_acc.number_of_packets_processed /for_avg_acc.arrival_count);
+    //fprintf(fp, ("Arrival rate,"));
+    fprintf(fp, "%.3f, ", (double) totals[s].packet_arrival_rate);
 
-      //fprintf(fp, ("Arrival rate,"));
-      fprintf(fp, "%.3f, ", (double) for_avg_acc.packet_arrival_rate);
+    //fprintf(fp, ("Mean Delay (msec),"));
+    fprintf(fp, "%f, ",1e3*totals[s].accumulated_delay/totals[s].number_of_packets_processed);
+  }
+  fprintf(fp, "\n");
+  fclose(fp);
+#endif
 
-      //fprintf(fp, ("Mean Delay (msec),"));
-      fprintf(fp, "%f, ",1e3*for_avg_acc.accumulated_delay/for_avg_acc.number_of_packets_processed);
+  printf("\n");
+  printf("i loop var = %f \n", p12_cutoff);
 
-  //sw2
-      //fprintf(fp, ("Random Seed,"));
-      fprintf(fp, "%d,", i);
+  for (s = 0; s < switch_count; s++) {
+    printf("\nsw%d \n", s+1);
+    printf("avg Random Seed = %d \n", totals[s].random_seed);
+    printf("avg Packet arrival count = %ld \n", totals[s].arrival_count);
 
-      //fprintf(fp, ("Packet arrival count,")_2);
-      fprintf(fp, "%ld, ", for_avg_acc.arrival_count_2);
+    xmtted_fraction = (double) totals[s].number_of_packets_processed /totals[s].arrival_count;
 
-      //fprintf(fp, ("Transmitted packet count ,")_2);
-      fprintf(fp, "%ld,", for_avg_acc.number_of_packets_processed_2);
+    printf("avg Transmitted packet count  = %ld (Service Fraction = %.5f)\n", totals[s].number_of_packets_processed, xmtted_fraction);
 
-      //fprintf(fp, ("Service Fraction ,")_2);
-      fprintf(fp, "%.5f,", (double) for_avg_acc.number_of_packets_processed_2 /for_avg_acc.arrival_count_2);
+    printf("avg Arrival rate = %.3f packets/second \n", (double) totals[s].packet_arrival_rate);
 
-      //fprintf(fp, ("Arrival rate,")_2);
-      fprintf(fp, "%.3f, ", (double) for_avg_acc.packet_arrival_rate_2);
+    if (s == 0)
+      printf("accumulated_delay (msec) = %f \n",1e3*totals[s].accumulated_delay);
+    printf("avg Mean Delay (msec) = %f \n",1e3*totals[s].accumulated_delay/totals[s].number_of_packets_processed);
+  }
+  printf("\n");
+}
 
-      //fprintf(fp, ("Mean Delay (msec),")_2);
-      fprintf(fp, "%f, ",1e3*for_avg_acc.accumulated_delay_2/for_avg_acc.number_of_packets_processed_2);
+/*
+ * Commit function for replication_run_all(). The replications come in job
+ * order, so the totals of each sweep point are added up seed by seed, the
+ * same way whatever the number of threads.
+ */
 
-  //sw3
-      //fprintf(fp, ("Random Seed,"));
-      fprintf(fp, "%d,", i);
+static void
+replication_done(long int job, int switch_count, Switch_Totals * run,
+		 void * ctx)
+{
+  Sweep_Totals * sweep = (Sweep_Totals *) ctx;
+  Switch_Totals * totals = sweep->switches;
+  int seed_count = sweep->config->random_seed_list.count;
+  int s;
+
+  if (job % seed_count == 0)
+    for (s = 0; s < switch_count; s++) {
+      totals[s].packet_arrival_rate = 0;
+      totals[s].arrival_count = 0;
+      totals[s].number_of_packets_processed = 0;
+      totals[s].accumulated_delay = 0;
+      totals[s].random_seed = 0;
+    }
+
+  for (s = 0; s < switch_count; s++) {
+    totals[s].packet_arrival_rate += run[s].packet_arrival_rate;
+    totals[s].arrival_count += run[s].arrival_count;
+    totals[s].number_of_packets_processed += run[s].number_of_packets_processed;
+    totals[s].accumulated_delay += run[s].accumulated_delay;
+    totals[s].random_seed += run[s].random_seed;
+  }
 
-      //fprintf(fp, ("Packet arrival count,")_3);
-      fprintf(fp, "%ld, ", for_avg_acc.arrival_count_3);
+  if (job % seed_count == seed_count - 1)
+    sweep_point_done(sweep, job / seed_count, switch_count);
+}
 
-      //fprintf(fp, ("Transmitted packet count ,")_3);
-      fprintf(fp, "%ld,", for_avg_acc.number_of_packets_processed_3);
+/*
+ * Time the whole sweep on 1 to config->threads threads, with the output of
+ * the replications thrown away, and print the speedup of each.
+ */
 
-      //fprintf(fp, ("Service Fraction ,")_3);
-      fprintf(fp, "%.5f,", (double) for_avg_acc.number_of_packets_processed_3 /for_avg_acc.arrival_count_3);
+static void
+scaling_report(Config_Ptr config)
+{
+  struct timespec start, end;
+  double seconds, serial_seconds = 0;
+  int threads;
 
-      //fprintf(fp, ("Arrival rate,")_3);
-      fprintf(fp, "%.3f, ", (double) for_avg_acc.packet_arrival_rate_3);
+  printf("Scaling report: %ld replications\n",
+	 config_sweep_count(config) * config->random_seed_list.count);
+  printf("threads  seconds  speedup  efficiency\n");
 
-      //fprintf(fp, ("Mean Delay (msec),")_3);
-      fprintf(fp, "%f, ",1e3*for_avg_acc.accumulated_delay_3/for_avg_acc.number_of_packets_processed_3);
-      fprintf(fp, "\n");
-      fclose(fp);
-  #endif
+  for (threads = 1; threads <= config->threads; threads++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replication_run_all(config, threads, 0, NULL, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-      double xmtted_fraction;
-      double xmtted_fraction_2;
-      double xmtted_fraction_3;
-      printf("\n");
-      printf("i loop var = %f \n", P12_CUTOFF_LIST[i]);
-      printf("\nsw1 \n");
-      printf("avg Random Seed = %d \n", for_avg_acc.random_seed);
-      printf("avg Packet arrival count = %ld \n", for_avg_acc.arrival_count);
-    
-      xmtted_fraction = (double) for_avg_acc.number_of_packets_processed /for_avg_acc.arrival_count;
-    
-      printf("avg Transmitted packet count  = %ld (Service Fraction = %.5f)\n", for_avg_acc.number_of_packets_processed, xmtted_fraction);
-    
-      printf("avg Arrival rate = %.3f packets/second \n", (double) for_avg_acc.packet_arrival_rate);
-    
-      printf("accumulated_delay (msec) = %f \n",1e3*for_avg_acc.accumulated_delay);
-      printf("avg Mean Delay (msec) = %f \n",1e3*for_avg_acc.accumulated_delay/for_avg_acc.number_of_packets_processed);
-    
-  //sw2
-      printf("\nsw2 \n");
-      printf("avg Random Seed = %d \n", for_avg_acc.random_seed_2);
-      printf("avg Packet arrival count = %ld \n", for_avg_acc.arrival_count_2);
-    
-      xmtted_fraction_2 = (double) for_avg_acc.number_of_packets_processed_2 /for_avg_acc.arrival_count_2;
-    
-      printf("avg Transmitted packet count  = %ld (Service Fraction = %.5f)\n", for_avg_acc.number_of_packets_processed_2, xmtted_fraction_2);
-    
-      printf("avg Arrival rate = %.3f packets/second \n", (double) for_avg_acc.packet_arrival_rate_2);
-    
-      printf("avg Mean Delay (msec) = %f \n",1e3*for_avg_acc.accumulated_delay_2/for_avg_acc.number_of_packets_processed_2);
-
-  //sw3
-      printf("\nsw3 \n");
-      printf("avg Random Seed = %d \n", for_avg_acc.random_seed_3);
-      printf("avg Packet arrival count = %ld \n", for_avg_acc.arrival_count_3);
-    
-      xmtted_fraction_3 = (double) for_avg_acc.number_of_packets_processed_3 /for_avg_acc.arrival_count_3;
-    
-      printf("avg Transmitted packet count  = %ld (Service Fraction = %.5f)\n", for_avg_acc.number_of_packets_processed_3, xmtted_fraction_3);
-    
-      printf("avg Arrival rate = %.3f packets/second \n", (double) for_avg_acc.packet_arrival_rate_3);
-    
-      printf("avg Mean Delay (msec) = %f \n",1e3*for_avg_acc.accumulated_delay_3/for_avg_acc.number_of_packets_processed_3);
-      printf("\n");
+    seconds = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+    if (threads == 1)
+      serial_seconds = seconds;
 
+    printf("%7d  %7.3f  %7.2f  %9.1f%%\n", threads, seconds,
+	   serial_seconds / seconds, 100 * serial_seconds / seconds / threads);
   }
-
-  //getchar();   /* Pause before finishing. */
-  return 0;
 }
 
+/*
+ * main.c loads the configuration, starting from the defaults in
+ * simparameters.h and applying the config files and flags given on the
+ * command line (see config.h). It then has replication_run_all() run every
+ * combination of the configured arrival rates and SW1 to SW2 routing
+ * probabilities with each of the random number generator seeds, on
+ * config.threads threads. Each replication prints its own results, except
+ * with config.lockstep, where the lockstep engine prints nothing. As the
+ * replications of a sweep point are committed, their averages over the seeds
+ * are printed and written to Q4.csv.
+ */
+
+int
+main(int argc, char ** argv)
+{
+  Config config;
+  Sweep_Totals sweep;
+  int s;
 
+  config_init(&config);
+  config_load(&config, argc, argv);
 
+  if (config.scaling_report) {
+    scaling_report(&config);
+    config_free(&config);
+    return 0;
+  }
 
+  int size_rand_seed = config.random_seed_list.count;
+  printf("size_rand_seed = %d \n", size_rand_seed);
 
+  #ifndef NO_CSV_OUTPUT
+  // create a csv file
+  FILE* fp;
+  //file IO
 
+  fp = fopen(CSV_FILE_NAME, "w");
+  //cell/element name/type
 
+  /* One group of columns for each of the three switches. */
 
+  for (s = 0; s < 3; s++) {
+    fprintf(fp, ("Random Seed,"));
+    fprintf(fp, ("Packet arrival count,"));
 
+    fprintf(fp, ("Transmitted packet count ,"));
+    fprintf(fp, ("Service Fraction ,"));
+    fprintf(fp, ("Arrival rate,"));
+    fprintf(fp, ("Mean Delay (msec),"));
+  }
+  fprintf(fp, "\n");
+  fclose(fp);
+  #endif
 
+  sweep.config = &config;
+  replication_run_all(&config, config.threads, 1, replication_done,
+		      (void *) & sweep);
 
+  config_free(&config);
 
+  //getchar();   /* Pause before finishing. */
+  return 0;
+}
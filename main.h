@@ -28,59 +28,203 @@
 
 /******************************************************************************/
 
+#include <stdint.h>
 #include "simlib.h"
 #include "simparameters.h"
+#include "config.h"
 
 /******************************************************************************/
 
-typedef struct _simulation_run_data_ 
+/*
+ * Packets are kept in a packet table and addressed by 32 bit Packet_Index
+ * values. The table is a slab of fixed size chunks of PACKET_CHUNK_SIZE
+ * packets, so that a packet never moves once it has been created. Each packet
+ * holds the index of the next packet on whichever packet queue it is on (or on
+ * the table's free list), so a packet queue is just a head and tail index.
+ *
+ * New packets come from the free list, or else from next_unused, the first
+ * packet that has never been handed out. Resetting the table for a new run
+ * only empties the free list and sets next_unused back to 0, so the chunks are
+ * kept and reused without being walked. The table counts the packets that are
+ * live (handed out and not yet freed) and the peak of that count since the
+ * last reset. A table made with packet_table_new_in_arena takes its chunks
+ * from that arena, normally the arena of the simulation_run it is used with.
+ */
+
+typedef uint32_t Packet_Index;
+
+#define NO_PACKET ((Packet_Index) 0xFFFFFFFF)
+
+#define PACKET_CHUNK_BITS 10
+#define PACKET_CHUNK_SIZE (1 << PACKET_CHUNK_BITS)
+
+typedef enum {XMTTING, WAITING} Packet_Status;
+
+/*
+ * A packet is kept to 16 bytes so that large buffers stay small. The service
+ * time is not stored, since it only depends on the link the packet is sent
+ * on, so start_transmission_on_link() gets it from that link's switch. The
+ * switch the packet came from (source_id), the switch it is at (switch_id)
+ * and the Packet_Status are kept in single bytes.
+ */
+
+typedef struct _packet_ 
+{
+  Sim_Time arrive_time;
+  Packet_Index next;
+  uint8_t source_id;
+  uint8_t switch_id;
+  uint8_t status;
+} Packet, * Packet_Ptr;
+
+typedef struct _packet_table_
+{
+  Arena_Ptr arena;
+  Packet ** chunks;
+  int chunk_count;
+  int chunk_capacity;
+  Packet_Index free_packet;
+  Packet_Index next_unused;
+  long int live;
+  long int peak_live;
+} Packet_Table, * Packet_Table_Ptr;
+
+typedef struct _packet_queue_
+{
+  Packet_Index head;
+  Packet_Index tail;
+  int size;
+} Packet_Queue, * Packet_Queue_Ptr;
+
+/*
+ * The network is described by a Topology, which lists its switches. Each
+ * switch has one output link with a fixed packet transmission time, and a
+ * buffer in front of it. Packets enter the network at a switch from its own
+ * Poisson source, if its arrival rate is above 0. When a packet has been
+ * transmitted it is forwarded to one of the switch's next hops, or leaves the
+ * network if the switch has none. The next hop is drawn at random, the k-th
+ * one with probability next_hop_probability[k]. The probabilities must add up
+ * to 1. A packet that leaves the network is counted, and its delay
+ * accumulated, against the switch it came from.
+ */
+
+#define MAX_SWITCHES 16
+#define MAX_NEXT_HOPS 64
+
+typedef struct _switch_config_
 {
-  double p12_cutoff;
-  Fifoqueue_Ptr buffer;
-  Server_Ptr link;
   double packet_arrival_rate;
+  double packet_xmt_time;
+  int next_hop_count;
+  int next_hop[MAX_NEXT_HOPS];
+  double next_hop_probability[MAX_NEXT_HOPS];
+} Switch_Config;
+
+typedef struct _topology_
+{
+  int switch_count;
+  Switch_Config switches[MAX_SWITCHES];
+} Topology, * Topology_Ptr;
+
+/*
+ * A Routing_Table is built from the next hops of a switch by
+ * routing_table_build() and used to draw the next hop of each packet with one
+ * uniform random number. With up to ROUTING_SCAN_MAX_HOPS next hops, cutoff
+ * holds the cumulative probabilities, which are scanned in order. With more,
+ * the table is a Walker alias table. The draw picks a column, and the column
+ * gives either its own next hop or its alias, depending on how the draw
+ * compares with the column's cutoff.
+ */
+
+#define ROUTING_SCAN_MAX_HOPS 4
+
+typedef struct _routing_table_
+{
+  int count;
+  int use_alias;
+  int next_hop[MAX_NEXT_HOPS];
+  int alias[MAX_NEXT_HOPS];
+  double cutoff[MAX_NEXT_HOPS];
+} Routing_Table;
+
+/*
+ * The state of each switch during a run. The event descriptions are built
+ * from the switch name when the switches are created.
+ */
+
+typedef struct _switch_
+{
+  int id;
+  char name[16];
+  char arrival_description[48];
+  char forward_description[48];
+  char end_description[48];
+  Switch_Config * config;
+  Sim_Time xmt_time;
+  Routing_Table routing;
+
+  Packet_Queue buffer;
+  Server_Ptr link;
   long int blip_counter;
   long int arrival_count;
   long int number_of_packets_processed;
   double accumulated_delay;
+} Switch, * Switch_Ptr;
+
+/*
+ * Totals of the results of a switch over the replications for one topology.
+ * main.c divides them by the number of replications to print the averages.
+ * Each replication hands back the results of its run in the same form.
+ */
+
+typedef struct _switch_totals_
+{
+  double packet_arrival_rate;
+  long int arrival_count;
+  long int number_of_packets_processed;
+  double accumulated_delay;
   unsigned random_seed;
+} Switch_Totals;
 
-  Fifoqueue_Ptr buffer_2;
-  Server_Ptr link_2;
-  double packet_arrival_rate_2;
-  long int blip_counter_2;
-  long int arrival_count_2;
-  long int number_of_packets_processed_2;
-  double accumulated_delay_2;
-  unsigned random_seed_2;
-
-  Fifoqueue_Ptr buffer_3;
-  Server_Ptr link_3;
-  double packet_arrival_rate_3;
-  long int blip_counter_3;
-  long int arrival_count_3;
-  long int number_of_packets_processed_3;
-  double accumulated_delay_3;
-  unsigned random_seed_3;
-} Simulation_Run_Data, * Simulation_Run_Data_Ptr;
+/*
+ * The sweep point that main.c is adding up the replications of.
+ */
 
-typedef enum {XMTTING, WAITING} Packet_Status;
+typedef struct _sweep_totals_
+{
+  Config_Ptr config;
+  Switch_Totals switches[MAX_SWITCHES];
+} Sweep_Totals;
 
-typedef struct _packet_ 
+/*
+ * Event kinds. When TYPED_EVENT_DISPATCH is defined in simparameters.h, events
+ * are scheduled by kind and run_events_by_kind() calls the event function
+ * named by each kind directly. Packet arrivals and transmission ends carry
+ * the switch id as their payload. Forwarded packet arrivals carry the
+ * Packet_Index of the packet.
+ */
+
+typedef enum {
+  PACKET_ARRIVAL_EVENT = 1,
+  FORWARDED_PACKET_ARRIVAL_EVENT,
+  END_PACKET_TRANSMISSION_EVENT
+} Event_Kind;
+
+typedef struct _simulation_run_data_ 
 {
-  double arrive_time;
-  double service_time;
-  int source_id;
-  int destination_id;
-  Packet_Status status;
-} Packet, * Packet_Ptr;
+  Config_Ptr config;
+  Packet_Table_Ptr packets;
+  Topology topology;
+  unsigned random_seed;
+  Switch switches[MAX_SWITCHES];
+} Simulation_Run_Data, * Simulation_Run_Data_Ptr;
 
 /*
  * Function prototypes
  */
 
 int
-main(void);
+main(int, char **);
 
 /******************************************************************************/
 
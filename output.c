@@ -26,98 +26,45 @@
 #include <stdio.h>
 #include "simparameters.h"
 #include "main.h"
+#include "packet_table.h"
 #include "output.h"
 
 /******************************************************************************/
 
 /*
  * This function outputs a progress message to the screen to indicate this are
- * working.
+ * working. It is called for a switch each time it finishes transmitting a
+ * packet.
  */
 
 void
-output_progress_msg_to_screen(Simulation_Run_Ptr simulation_run)
+output_progress_msg_to_screen(Simulation_Run_Ptr simulation_run, Switch_Ptr sw)
 {
+  Config_Ptr config;
+  FILE * output;
   double percentage_done;
-  Simulation_Run_Data_Ptr data;
 
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+  config = ((Simulation_Run_Data_Ptr)
+	    simulation_run_data(simulation_run))->config;
+  output = simulation_run_output(simulation_run);
 
-  data->blip_counter++;
+  sw->blip_counter++;
 
-  if((data->blip_counter >= BLIPRATE)
+  if((sw->blip_counter >= config->blip_rate)
      ||
-     (data->number_of_packets_processed >= RUNLENGTH)) {
+     (sw->number_of_packets_processed >= config->runlength)) {
 
-    data->blip_counter = 0;
+    sw->blip_counter = 0;
 
     percentage_done =
-      100 * (double) data->number_of_packets_processed/RUNLENGTH;
+      100 * (double) sw->number_of_packets_processed/config->runlength;
 
-    printf("%3.0f%% ", percentage_done);
+    fprintf(output, "%3.0f%% ", percentage_done);
 
-    printf("SW1 Successfully Xmtted Pkts  = %ld (Arrived Pkts = %ld) \n", 
-	   data->number_of_packets_processed, data->arrival_count);
+    fprintf(output, "%s Successfully Xmtted Pkts  = %ld (Arrived Pkts = %ld) \n", 
+	    sw->name, sw->number_of_packets_processed, sw->arrival_count);
 
-    fflush(stdout);
-  }
-
-}
-
-void
-output_progress_msg_to_screen_sw2(Simulation_Run_Ptr simulation_run)
-{
-  double percentage_done;
-  Simulation_Run_Data_Ptr data;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-
-  data->blip_counter_2++;
-
-  if((data->blip_counter_2 >= BLIPRATE)
-     ||
-     (data->number_of_packets_processed_2 >= RUNLENGTH)) {
-
-    data->blip_counter_2 = 0;
-
-    percentage_done =
-      100 * (double) data->number_of_packets_processed_2/RUNLENGTH;
-
-    printf("%3.0f%% ", percentage_done);
-
-    printf("SW2 Successfully Xmtted Pkts  = %ld (Arrived Pkts = %ld) \n", 
-	   data->number_of_packets_processed_2, data->arrival_count_2);
-
-    fflush(stdout);
-  }
-
-}
-
-void
-output_progress_msg_to_screen_sw3(Simulation_Run_Ptr simulation_run)
-{
-  double percentage_done;
-  Simulation_Run_Data_Ptr data;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-
-  data->blip_counter_3++;
-
-  if((data->blip_counter_3 >= BLIPRATE)
-     ||
-     (data->number_of_packets_processed_3 >= RUNLENGTH)) {
-
-    data->blip_counter_3 = 0;
-
-    percentage_done =
-      100 * (double) data->number_of_packets_processed_3/RUNLENGTH;
-
-    printf("%3.0f%% ", percentage_done);
-
-    printf("SW3 Successfully Xmtted Pkts  = %ld (Arrived Pkts = %ld) \n", 
-	   data->number_of_packets_processed_3, data->arrival_count_3);
-
-    fflush(stdout);
+    fflush(output);
   }
 
 }
@@ -131,115 +78,64 @@ void
 output_results(Simulation_Run_Ptr simulation_run)
 {
   double xmtted_fraction;
+  Eventlist_Switch eventlist_switch;
+  Switch_Ptr sw;
+  int i;
   Simulation_Run_Data_Ptr data;
+  FILE * output;
 
   data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+  output = simulation_run_output(simulation_run);
 
-  printf("\n");
-  printf("SW1: \n");
-  printf("Random Seed = %d \n", data->random_seed);
-  printf("Packet arrival count = %ld \n", data->arrival_count);
-
-  xmtted_fraction = (double) data->number_of_packets_processed /
-    data->arrival_count;
-
-  printf("Transmitted packet count  = %ld (Service Fraction = %.5f)\n",
-	 data->number_of_packets_processed, xmtted_fraction);
-
-  printf("Arrival rate = %.3f packets/second \n", (double) data->packet_arrival_rate);
-
-  printf("Mean Delay (msec) = %f \n",
-	 1e3*data->accumulated_delay/data->number_of_packets_processed);
-
-  printf("\n");
-
-  #ifndef NO_CSV_OUTPUT
-  /*
-  // create a csv file
-  FILE* fp;
-  char data_set_name[] = "./Q2.csv";
-
-  //file IO
-  fp = fopen(data_set_name, "a");
-  //cell/element name/type
-
-  //fprintf(fp, ("Random Seed,"));
-  fprintf(fp, "%d, ", data->random_seed);
-
-  //fprintf(fp, ("Packet arrival count,"));
-  fprintf(fp, "%ld, ", data->arrival_count);
-
-  //fprintf(fp, ("Transmitted packet count ,"));
-  fprintf(fp, "%ld,", data->number_of_packets_processed);
-
-  //fprintf(fp, ("Service Fraction ,"));
-  fprintf(fp, "%.5f,", xmtted_fraction);
-
-  //fprintf(fp, ("Arrival rate,"));
-  fprintf(fp, "%.3f, ", (double) data->packet_arrival_rate);
-
-  //fprintf(fp, ("Mean Delay (msec),"));
-  fprintf(fp, "%.2f, ",
-	 1e3*data->accumulated_delay/data->number_of_packets_processed);
-
-  fprintf(fp, "\n");
-
-  fclose(fp);
-  */
-  #endif
-}
-
-void
-output_results_sw2(Simulation_Run_Ptr simulation_run)
-{
-  double xmtted_fraction;
-  Simulation_Run_Data_Ptr data;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-
-  printf("\n");
-  printf("SW2: \n");
-  printf("Random Seed = %d \n", data->random_seed_2);
-  printf("Packet arrival count = %ld \n", data->arrival_count_2);
+  for (i=0; i<data->topology.switch_count; i++) {
+    sw = &data->switches[i];
 
-  xmtted_fraction = (double) data->number_of_packets_processed_2 /
-    data->arrival_count_2;
+    fprintf(output, "\n");
+    fprintf(output, "%s: \n", sw->name);
+    fprintf(output, "Random Seed = %d \n", data->random_seed);
+    fprintf(output, "Packet arrival count = %ld \n", sw->arrival_count);
 
-  printf("Transmitted packet count  = %ld (Service Fraction = %.5f)\n",
-	 data->number_of_packets_processed_2, xmtted_fraction);
+    xmtted_fraction = (double) sw->number_of_packets_processed /
+      sw->arrival_count;
 
-  printf("Arrival rate = %.3f packets/second \n", (double) data->packet_arrival_rate_2);
+    fprintf(output, "Transmitted packet count  = %ld (Service Fraction = %.5f)\n",
+	    sw->number_of_packets_processed, xmtted_fraction);
 
-  printf("Mean Delay (msec) = %f \n",
-	 1e3*data->accumulated_delay_2/data->number_of_packets_processed_2);
+    fprintf(output, "Arrival rate = %.3f packets/second \n",
+	    (double) sw->config->packet_arrival_rate);
 
-  printf("\n");
-}
+    fprintf(output, "Mean Delay (msec) = %f \n",
+	    1e3*sw->accumulated_delay/sw->number_of_packets_processed);
 
-void
-output_results_sw3(Simulation_Run_Ptr simulation_run)
-{
-  double xmtted_fraction;
-  Simulation_Run_Data_Ptr data;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+    fprintf(output, "\n");
+  }
 
-  printf("\n");
-  printf("SW3: \n");
-  printf("Random Seed = %d \n", data->random_seed_3);
-  printf("Packet arrival count = %ld \n", data->arrival_count_3);
+  fprintf(output, "Event pool hit rate = %.5f \n",
+	  simulation_run_event_pool_hit_rate(simulation_run));
 
-  xmtted_fraction = (double) data->number_of_packets_processed_3 /
-    data->arrival_count_3;
+  fprintf(output, "Event list = %s (%d switches) \n",
+	  eventlist_type_name(simulation_run_eventlist_type(simulation_run)),
+	  simulation_run_eventlist_switch_count(simulation_run));
 
-  printf("Transmitted packet count  = %ld (Service Fraction = %.5f)\n",
-	 data->number_of_packets_processed_3, xmtted_fraction);
+  for (i=0; i<simulation_run_eventlist_switch_count(simulation_run); i++) {
+    eventlist_switch = simulation_run_eventlist_switch(simulation_run, i);
+    fprintf(output, "  %s -> %s at %.3f sec (event %ld, %d pending) \n",
+	    eventlist_type_name(eventlist_switch.from),
+	    eventlist_type_name(eventlist_switch.to),
+	    SIM_TIME_TO_SECONDS(eventlist_switch.time),
+	    eventlist_switch.events_executed, eventlist_switch.size);
+  }
 
-  printf("Arrival rate = %.3f packets/second \n", (double) data->packet_arrival_rate_3);
+  fprintf(output, "Peak live packets = %ld (packet table capacity = %ld, %ld bytes) \n",
+	  packet_table_peak_live(data->packets),
+	  packet_table_capacity(data->packets),
+	  packet_table_bytes(data->packets));
 
-  printf("Mean Delay (msec) = %f \n",
-	 1e3*data->accumulated_delay_3/data->number_of_packets_processed_3);
+  fprintf(output, "Arena peak bytes = %lu (%lu reserved) \n",
+	  (unsigned long) arena_peak_bytes(simulation_run_arena(simulation_run)),
+	  (unsigned long)
+	  arena_reserved_bytes(simulation_run_arena(simulation_run)));
 
-  printf("\n");
+  fprintf(output, "\n");
 }
 
@@ -26,276 +26,109 @@
 #include <math.h>
 #include <stdio.h>
 #include "main.h"
+#include "packet_table.h"
 #include "packet_transmission.h"
 #include "packet_arrival.h"
+#include "switch_events.h"
 
 /******************************************************************************/
 
 /*
- * This function will schedule a packet arrival at a time given by
- * event_time. At that time the function "packet_arrival" (located in
- * packet_arrival.c) is executed. An object can be attached to the event and
- * can be recovered in packet_arrival.c.
+ * This function will schedule a packet arrival from the source of a switch at
+ * a time given by event_time. At that time the function "packet_arrival"
+ * (located in packet_arrival.c) is executed with the switch.
  */
 
-long int
+Event_Handle
 schedule_packet_arrival_event(Simulation_Run_Ptr simulation_run,
-			      double event_time)
+			      Sim_Time event_time, Switch_Ptr sw)
 {
+#ifdef TYPED_EVENT_DISPATCH
+  return simulation_run_schedule_kind_event(simulation_run,
+					    PACKET_ARRIVAL_EVENT, sw->id,
+					    sw->arrival_description,
+					    event_time);
+#else
   Event event;
 
-  event.description = "SW1 Packet Arrival";
+  event.description = sw->arrival_description;
   event.function = packet_arrival_event;
-  event.attachment = (void *) NULL;
+  event.attachment = (void *) sw;
 
-  return simulation_run_schedule_event(simulation_run, event, event_time);
+  return simulation_run_schedule_event_sim_time(simulation_run, event,
+						event_time);
+#endif
 }
 
-long int
-schedule_packet_arrival_event_sw2(Simulation_Run_Ptr simulation_run,
-			      double event_time)
-{
-  Event event;
-
-  event.description = "SW2 Packet Arrival";
-  event.function = packet_arrival_event_sw2;
-  event.attachment = (void *) NULL;
-
-  return simulation_run_schedule_event(simulation_run, event, event_time);
-}
+/*
+ * Schedule the arrival of a packet forwarded by another switch. The packet's
+ * switch_id must already be set to the switch it is going to.
+ */
 
-long int
-schedule_packet_arrival_event_sw3(Simulation_Run_Ptr simulation_run,
-			      double event_time)
+Event_Handle
+schedule_forwarded_packet_arrival_event(Simulation_Run_Ptr simulation_run,
+					Sim_Time event_time,
+					Packet_Index packet)
 {
-  Event event;
-
-  event.description = "SW3 Packet Arrival";
-  event.function = packet_arrival_event_sw3;
-  event.attachment = (void *) NULL;
-
-  return simulation_run_schedule_event(simulation_run, event, event_time);
-}
+  Simulation_Run_Data_Ptr data;
+  Switch_Ptr sw;
 
-long int
-schedule_packet_arrival_event_sw2_only_once(Simulation_Run_Ptr simulation_run, double event_time, Packet_Ptr packet)
-{
+  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+  sw = &data->switches[PACKET_PTR(data->packets, packet)->switch_id];
+
+#ifdef TYPED_EVENT_DISPATCH
+  return simulation_run_schedule_kind_event(simulation_run,
+					    FORWARDED_PACKET_ARRIVAL_EVENT,
+					    (uint32_t) packet,
+					    sw->forward_description,
+					    event_time);
+#else
   Event event;
 
-  event.description = "from SW1 only once SW2 Packet Arrival";
-  event.function = packet_arrival_event_sw2_only_once;
-  event.attachment = (Packet_Ptr *) packet;
+  event.description = sw->forward_description;
+  event.function = forwarded_packet_arrival_event;
+  event.attachment = PACKET_INDEX_TO_VOID(packet);
 
-  return simulation_run_schedule_event(simulation_run, event, event_time);
+  return simulation_run_schedule_event_sim_time(simulation_run, event,
+						event_time);
+#endif
 }
 
-long int
-schedule_packet_arrival_event_sw3_only_once(Simulation_Run_Ptr simulation_run, double event_time, Packet_Ptr packet)
-{
-  Event event;
-
-  event.description = "from SW1 only once SW3 Packet Arrival";
-  event.function = packet_arrival_event_sw3_only_once;
-  //event.attachment = (void *) NULL;
-  event.attachment = (Packet_Ptr *) packet;
-
-  return simulation_run_schedule_event(simulation_run, event, event_time);
-}
 /******************************************************************************/
 
 /*
  * This is the event function which is executed when a packet arrival event
- * occurs. It creates a new packet object and places it in either the fifo
- * queue if the server is busy. Otherwise it starts the transmission of the
- * packet. It then schedules the next packet arrival event.
+ * occurs. See switch_packet_arrival() in switch_events.h.
  */
 
 void
 packet_arrival_event(Simulation_Run_Ptr simulation_run, void * ptr)
 {
   Simulation_Run_Data_Ptr data;
-  Packet_Ptr new_packet;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-  data->arrival_count++;
-
-  new_packet = (Packet_Ptr) xmalloc(sizeof(Packet));
-  new_packet->arrive_time = simulation_run_get_time(simulation_run);
-  new_packet->service_time = get_packet_transmission_time();
-  new_packet->status = WAITING;
-
-  /* 
-   * Start transmission if the data link is free. Otherwise put the packet into
-   * the buffer.
-   */
-
-  if(server_state(data->link) == BUSY) {
-    fifoqueue_put(data->buffer, (void*) new_packet);
-  } else {
-    start_transmission_on_link(simulation_run, new_packet, data->link);
-  }
-
-  /* 
-   * Schedule the next packet arrival. Independent, exponentially distributed
-   * interarrival times gives us Poisson process arrivals.
-   */
-
-#ifdef D_D_1_system
-  schedule_packet_arrival_event(simulation_run,simulation_run_get_time(simulation_run) + (double) 1/data->packet_arrival_rate);
-#else
-  schedule_packet_arrival_event(simulation_run,simulation_run_get_time(simulation_run) + exponential_generator((double) 1/data->packet_arrival_rate));
-#endif
-}
-
-void
-packet_arrival_event_sw2(Simulation_Run_Ptr simulation_run, void * ptr)
-{
-  Simulation_Run_Data_Ptr data;
-  Packet_Ptr new_packet;
+  Switch_Ptr sw = (Switch_Ptr) ptr;
 
   data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-  data->arrival_count_2++;
-
-  new_packet = (Packet_Ptr) xmalloc(sizeof(Packet));
-  new_packet->source_id = 2;
-  new_packet->arrive_time = simulation_run_get_time(simulation_run);
-  new_packet->service_time = get_packet_transmission_time_sw2();
-  
-  //printf("service time  %f\n", get_packet_transmission_time_sw2());
-
-  new_packet->status = WAITING;
-
-  /* 
-   * Start transmission if the data link is free. Otherwise put the packet into
-   * the buffer.
-   */
-
-  if(server_state(data->link_2) == BUSY) {
-    fifoqueue_put(data->buffer_2, (void*) new_packet);
-  } else {
-    start_transmission_on_link_sw2(simulation_run, new_packet, data->link_2);
-  }
-
-  /* 
-   * Schedule the next packet arrival. Independent, exponentially distributed
-   * interarrival times gives us Poisson process arrivals.
-   */
-
-#ifdef D_D_1_system
-  schedule_packet_arrival_event_sw2(simulation_run,simulation_run_get_time(simulation_run) + (double) 1/data->packet_arrival_rate_2);
-#else
-  schedule_packet_arrival_event_sw2(simulation_run,simulation_run_get_time(simulation_run) + exponential_generator((double) 1/data->packet_arrival_rate_2));
-#endif
+  switch_packet_arrival(simulation_run, data, sw->id,
+			sw->config->packet_arrival_rate, sw->xmt_time, 0);
 }
 
-void
-packet_arrival_event_sw3(Simulation_Run_Ptr simulation_run, void * ptr)
-{
-  Simulation_Run_Data_Ptr data;
-  Packet_Ptr new_packet;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-  data->arrival_count_3++;
-
-  new_packet = (Packet_Ptr) xmalloc(sizeof(Packet));
-  new_packet->source_id = 3;
-  new_packet->arrive_time = simulation_run_get_time(simulation_run);
-  new_packet->service_time = get_packet_transmission_time_sw3();
-  new_packet->status = WAITING;
-
-  /* 
-   * Start transmission if the data link is free. Otherwise put the packet into
-   * the buffer.
-   */
-
-  if(server_state(data->link_3) == BUSY) {
-    fifoqueue_put(data->buffer_3, (void*) new_packet);
-  } else {
-    start_transmission_on_link_sw3(simulation_run, new_packet, data->link_3);
-  }
-
-  /* 
-   * Schedule the next packet arrival. Independent, exponentially distributed
-   * interarrival times gives us Poisson process arrivals.
-   */
-
-#ifdef D_D_1_system
-  schedule_packet_arrival_event_sw3(simulation_run,simulation_run_get_time(simulation_run) + (double) 1/data->packet_arrival_rate_3);
-#else
-  schedule_packet_arrival_event_sw3(simulation_run,simulation_run_get_time(simulation_run) + exponential_generator((double) 1/data->packet_arrival_rate_3));
-#endif
-}
-
-void
-packet_arrival_event_sw2_only_once(Simulation_Run_Ptr simulation_run, void * ptr)
-{
-  Simulation_Run_Data_Ptr data;
-  Packet_Ptr sw1_packet;
-  sw1_packet = ptr;
-
-  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-  //data->arrival_count_2++;
-  if (sw1_packet->source_id != 1)
-  {
-      printf("Error source_id not eq 1 ! \n"); 
-  }
-
-  //sw1_packet = (Packet_Ptr) xmalloc(sizeof(Packet));
-  //sw1_packet->arrive_time = simulation_run_get_time(simulation_run);
-  sw1_packet->source_id = 1;
-  sw1_packet->service_time = get_packet_transmission_time_sw2();
-  sw1_packet->status = WAITING;
-
-  /* 
-   * Start transmission if the data link is free. Otherwise put the packet into
-   * the buffer.
-   */
-
-  if(server_state(data->link_2) == BUSY) {
-    fifoqueue_put(data->buffer_2, (void*) sw1_packet);
-  } else {
-    start_transmission_on_link_sw2_only_once(simulation_run, sw1_packet, data->link_2);
-  }
-
-  /* 
-   * Schedule the next packet arrival. Independent, exponentially distributed
-   * interarrival times gives us Poisson process arrivals.
-   */
-}
+/*
+ * This is the event function which is executed when a packet forwarded by
+ * another switch arrives. See switch_forwarded_packet_arrival() in
+ * switch_events.h.
+ */
 
 void
-packet_arrival_event_sw3_only_once(Simulation_Run_Ptr simulation_run, void * ptr)
+forwarded_packet_arrival_event(Simulation_Run_Ptr simulation_run, void * ptr)
 {
   Simulation_Run_Data_Ptr data;
-  Packet_Ptr sw1_packet;
-  sw1_packet = ptr;
+  Packet_Index packet_index;
+  Switch_Ptr sw;
 
   data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
-  //data->arrival_count_3++;
-  if (sw1_packet->source_id != 1)
-  {
-      printf("Error source_id not eq 1 ! \n"); 
-  }
-
-  //sw1_packet = (Packet_Ptr) xmalloc(sizeof(Packet));
-  sw1_packet->source_id = 1;
-  //sw1_packet->arrive_time = simulation_run_get_time(simulation_run);
-  sw1_packet->service_time = get_packet_transmission_time_sw3();
-  sw1_packet->status = WAITING;
-
-  /* 
-   * Start transmission if the data link is free. Otherwise put the packet into
-   * the buffer.
-   */
-
-  if(server_state(data->link_3) == BUSY) {
-    fifoqueue_put(data->buffer_3, (void*) sw1_packet);
-  } else {
-    start_transmission_on_link_sw3_only_once(simulation_run, sw1_packet, data->link_3);
-  }
+  packet_index = PACKET_INDEX_FROM_VOID(ptr);
+  sw = &data->switches[PACKET_PTR(data->packets, packet_index)->switch_id];
 
-  /* 
-   * Schedule the next packet arrival. Independent, exponentially distributed
-   * interarrival times gives us Poisson process arrivals.
-   */
+  switch_forwarded_packet_arrival(simulation_run, data, packet_index, sw->id,
+				  sw->xmt_time, 0);
 }
@@ -28,7 +28,7 @@
 
 /******************************************************************************/
 
-#include "simlib.h"
+#include "main.h"
 
 /******************************************************************************/
 
@@ -37,13 +37,14 @@
  */
 
 void packet_arrival_event(Simulation_Run_Ptr, void*);
-void packet_arrival_event_sw2(Simulation_Run_Ptr, void*);
-void packet_arrival_event_sw3(Simulation_Run_Ptr, void*);
-void packet_arrival_event_sw2_only_once(Simulation_Run_Ptr, void*);
-void packet_arrival_event_sw3_only_once(Simulation_Run_Ptr, void*);
+void forwarded_packet_arrival_event(Simulation_Run_Ptr, void*);
 
-long
-schedule_packet_arrival_event(Simulation_Run_Ptr, double);
+Event_Handle
+schedule_packet_arrival_event(Simulation_Run_Ptr, Sim_Time, Switch_Ptr);
+
+Event_Handle
+schedule_forwarded_packet_arrival_event(Simulation_Run_Ptr, Sim_Time,
+					Packet_Index);
 
 /******************************************************************************/
 
@@ -0,0 +1,239 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include "main.h"
+#include "packet_table.h"
+
+/******************************************************************************/
+
+/*
+ * Create an empty packet table. Chunks are added as packets are needed.
+ */
+
+Packet_Table_Ptr
+packet_table_new(void)
+{
+  return packet_table_new_in_arena(NULL);
+}
+
+/*
+ * Create an empty packet table in an arena (or on the heap if the arena is
+ * NULL). The table and its chunks then live as long as the arena does.
+ */
+
+Packet_Table_Ptr
+packet_table_new_in_arena(Arena_Ptr arena)
+{
+  Packet_Table_Ptr table;
+
+  table = (Packet_Table_Ptr) arena_alloc(arena, sizeof(Packet_Table));
+  table->arena = arena;
+  table->chunks = NULL;
+  table->chunk_count = 0;
+  table->chunk_capacity = 0;
+  packet_table_reset(table);
+  return table;
+}
+
+/*
+ * Make every packet in the table free again. This takes constant time. Any
+ * packet indices that are still held become invalid.
+ */
+
+void
+packet_table_reset(Packet_Table_Ptr table)
+{
+  table->free_packet = NO_PACKET;
+  table->next_unused = 0;
+  table->live = 0;
+  table->peak_live = 0;
+}
+
+/*
+ * Free a packet table along with every packet in it, whether or not the
+ * packets are still in use. A table in an arena can also be left to be
+ * released with the arena.
+ */
+
+void
+packet_table_free(Packet_Table_Ptr table)
+{
+  int i;
+
+  for (i=0; i<table->chunk_count; i++)
+    arena_free(table->arena, table->chunks[i],
+	       PACKET_CHUNK_SIZE * sizeof(Packet));
+  if (table->chunks != NULL)
+    arena_free(table->arena, table->chunks,
+	       table->chunk_capacity * sizeof(Packet *));
+  arena_free(table->arena, table, sizeof(Packet_Table));
+}
+
+/*
+ * Get the number of live packets, the peak number since the table was created
+ * or reset, and the number of packets that the chunks can hold.
+ */
+
+long int
+packet_table_live(Packet_Table_Ptr table)
+{
+  return table->live;
+}
+
+long int
+packet_table_peak_live(Packet_Table_Ptr table)
+{
+  return table->peak_live;
+}
+
+long int
+packet_table_capacity(Packet_Table_Ptr table)
+{
+  return (long int) table->chunk_count * PACKET_CHUNK_SIZE;
+}
+
+/*
+ * Get the number of bytes the table has allocated, counting the chunks, the
+ * chunk pointer array and the table itself.
+ */
+
+long int
+packet_table_bytes(Packet_Table_Ptr table)
+{
+  return (long int) table->chunk_count * PACKET_CHUNK_SIZE * sizeof(Packet) +
+    (long int) table->chunk_capacity * sizeof(Packet *) +
+    (long int) sizeof(Packet_Table);
+}
+
+/*
+ * Hand out a packet. A recycled packet is taken from the free list if there
+ * is one. Otherwise the next unused packet is taken, adding a chunk if they
+ * have all been used.
+ */
+
+Packet_Index
+packet_new(Packet_Table_Ptr table)
+{
+  Packet_Index index;
+  int capacity;
+
+  if (table->free_packet != NO_PACKET) {
+    index = table->free_packet;
+    table->free_packet = PACKET_PTR(table, index)->next;
+  } else {
+    index = table->next_unused;
+    if ((index >> PACKET_CHUNK_BITS) == (Packet_Index) table->chunk_count) {
+      if (index == (NO_PACKET & ~(Packet_Index) (PACKET_CHUNK_SIZE - 1))) {
+	printf("Error: The packet table is full.\n");
+	exit(1);
+      }
+
+      if (table->chunk_count == table->chunk_capacity) {
+	capacity = table->chunk_capacity == 0 ? 8 : 2 * table->chunk_capacity;
+	table->chunks = (Packet **)
+	  arena_realloc(table->arena, table->chunks,
+			table->chunk_capacity * sizeof(Packet *),
+			capacity * sizeof(Packet *));
+	table->chunk_capacity = capacity;
+      }
+      table->chunks[table->chunk_count++] = (Packet_Ptr)
+	arena_alloc(table->arena, PACKET_CHUNK_SIZE * sizeof(Packet));
+    }
+    table->next_unused++;
+  }
+
+  if (++table->live > table->peak_live)
+    table->peak_live = table->live;
+
+  PACKET_PTR(table, index)->next = NO_PACKET;
+  return index;
+}
+
+/*
+ * Return a packet to the free list.
+ */
+
+void
+packet_free(Packet_Table_Ptr table, Packet_Index index)
+{
+  PACKET_PTR(table, index)->next = table->free_packet;
+  table->free_packet = index;
+  table->live--;
+}
+
+/*
+ * Packet queue functions. A packet queue is a FIFO queue of packets linked
+ * through their next fields.
+ */
+
+void
+packet_queue_init(Packet_Queue_Ptr queue)
+{
+  queue->head = NO_PACKET;
+  queue->tail = NO_PACKET;
+  queue->size = 0;
+}
+
+void
+packet_queue_put(Packet_Table_Ptr table, Packet_Queue_Ptr queue,
+		 Packet_Index index)
+{
+  PACKET_PTR(table, index)->next = NO_PACKET;
+
+  if (queue->size == 0)
+    queue->head = index;
+  else
+    PACKET_PTR(table, queue->tail)->next = index;
+
+  queue->tail = index;
+  queue->size++;
+}
+
+/*
+ * Take the packet at the front of a packet queue. NO_PACKET is returned if
+ * the queue is empty.
+ */
+
+Packet_Index
+packet_queue_get(Packet_Table_Ptr table, Packet_Queue_Ptr queue)
+{
+  Packet_Index index;
+
+  if (queue->size == 0)
+    return NO_PACKET;
+
+  index = queue->head;
+  queue->head = PACKET_PTR(table, index)->next;
+  if (--queue->size == 0)
+    queue->tail = NO_PACKET;
+  return index;
+}
+
+int
+packet_queue_size(Packet_Queue_Ptr queue)
+{
+  return queue->size;
+}
@@ -0,0 +1,75 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _PACKET_TABLE_H_
+#define _PACKET_TABLE_H_
+
+/******************************************************************************/
+
+#include "main.h"
+
+/******************************************************************************/
+
+/*
+ * Get a pointer to a packet from its index. The pointer stays valid for as
+ * long as the packet table exists.
+ */
+
+#define PACKET_PTR(table, index) \
+  (&(table)->chunks[(index) >> PACKET_CHUNK_BITS] \
+   [(index) & (PACKET_CHUNK_SIZE - 1)])
+
+/*
+ * A Packet_Index is passed through the void pointers of servers and event
+ * attachments by value.
+ */
+
+#define PACKET_INDEX_TO_VOID(index) ((void *) (uintptr_t) (index))
+#define PACKET_INDEX_FROM_VOID(ptr) ((Packet_Index) (uintptr_t) (ptr))
+
+/*
+ * Function prototypes
+ */
+
+Packet_Table_Ptr packet_table_new(void);
+Packet_Table_Ptr packet_table_new_in_arena(Arena_Ptr);
+void packet_table_reset(Packet_Table_Ptr);
+void packet_table_free(Packet_Table_Ptr);
+long int packet_table_live(Packet_Table_Ptr);
+long int packet_table_peak_live(Packet_Table_Ptr);
+long int packet_table_capacity(Packet_Table_Ptr);
+long int packet_table_bytes(Packet_Table_Ptr);
+Packet_Index packet_new(Packet_Table_Ptr);
+void packet_free(Packet_Table_Ptr, Packet_Index);
+
+void packet_queue_init(Packet_Queue_Ptr);
+void packet_queue_put(Packet_Table_Ptr, Packet_Queue_Ptr, Packet_Index);
+Packet_Index packet_queue_get(Packet_Table_Ptr, Packet_Queue_Ptr);
+int packet_queue_size(Packet_Queue_Ptr);
+
+/******************************************************************************/
+
+#endif /* packet_table.h */
+
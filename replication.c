@@ -0,0 +1,864 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * open_memstream() and clock_gettime() are POSIX, not C99.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "simlib.h"
+#include "main.h"
+#include "config.h"
+#include "packet_arrival.h"
+#include "packet_table.h"
+#include "topology.h"
+#include "static_topology.h"
+#include "event_dispatch.h"
+#include "cleanup_memory.h"
+#include "lockstep.h"
+#include "replication.h"
+
+/******************************************************************************/
+
+/*
+ * The result of a job. It is filled in by the worker that ran the job and
+ * handed back by the calling thread once done is set.
+ */
+
+typedef struct _replication_result_
+{
+  Switch_Totals * totals;
+  int switch_count;
+  char * output;
+  size_t output_size;
+  int done;
+} Replication_Result;
+
+typedef struct _replication_job_cost_
+{
+  double cost;
+  long int job;
+} Replication_Job_Cost;
+
+/*
+ * Each worker has a queue of tasks. A task is the jobs run by one call to
+ * the simulation: one job, or with the lockstep engine the jobs of up to
+ * config->lockstep consecutive seeds of a sweep point. Tasks are named by
+ * their first job. The tasks still to run are queue[head] to queue[tail - 1],
+ * each with its expected cost, most expensive first. remaining is the sum of
+ * their costs. The costs are those of the cost model when it was at
+ * model_version, and the queue is costed and sorted again when it is next
+ * taken from after the model has changed. The worker takes the task at the
+ * head, and when its queue is empty it steals the task at the head of
+ * another worker's queue. Each queue is guarded by its own queue_lock. A
+ * worker that holds a queue_lock may take the runner's lock, but not the
+ * other way round.
+ */
+
+typedef struct _replication_worker_
+{
+  struct _replication_runner_ * runner;
+  int id;
+  Simulation_Run_Ptr simulation_run;
+  Simulation_Run_Data data;
+  FILE * discard;
+  Lockstep_Ptr lockstep;
+  pthread_t thread;
+
+  pthread_mutex_t queue_lock;
+  Replication_Job_Cost * queue;
+  long int head;
+  long int tail;
+  double remaining;
+  long int model_version;
+
+  long int jobs_run;
+  long int jobs_stolen;
+  double busy_seconds;
+} Replication_Worker;
+
+/*
+ * The cost model. model_cost is the cost of each sweep point predicted from
+ * its offered load, in arbitrary units. Once jobs finish, measured_seconds
+ * and measured_count hold the time taken by the jobs of each point, and
+ * done_seconds / done_model_cost converts model units to seconds for the
+ * points that have none measured yet. model_version counts the changes to
+ * the model. The model and the results are guarded by lock.
+ */
+
+typedef struct _replication_runner_
+{
+  Config_Ptr config;
+  int keep_output;
+  int lanes;
+  long int job_count;
+  Replication_Result * results;
+  Replication_Worker * workers;
+  int worker_count;
+
+  double * model_cost;
+  double * measured_seconds;
+  long int * measured_count;
+  double done_model_cost;
+  double done_seconds;
+  long int model_version;
+
+  pthread_mutex_t lock;
+  pthread_cond_t job_done;
+} Replication_Runner;
+
+/******************************************************************************/
+
+/*
+ * Stopping condition for a run: the number of packets from the first switch
+ * delivered has reached the configured runlength.
+ */
+
+static int
+run_length_reached(Simulation_Run_Ptr simulation_run, void * ctx)
+{
+  Simulation_Run_Data_Ptr data = (Simulation_Run_Data_Ptr) ctx;
+
+  (void) simulation_run;
+  return data->switches[0].number_of_packets_processed >=
+    data->config->runlength;
+}
+
+/*
+ * Create the simulation_run of a worker, and its switches, with their buffers
+ * and links, from the topology of the first sweep point.
+ */
+
+static void
+replication_worker_init(Replication_Worker * worker, Replication_Runner * runner)
+{
+  Config_Ptr config = runner->config;
+  double packet_arrival_rate[3];
+  double p12_cutoff;
+
+  worker->runner = runner;
+  worker->discard = NULL;
+  worker->lockstep = runner->lanes > 1 ? lockstep_new() : NULL;
+  worker->queue = NULL;
+  worker->head = 0;
+  worker->tail = 0;
+  worker->remaining = 0;
+  worker->model_version = 0;
+  worker->jobs_run = 0;
+  worker->jobs_stolen = 0;
+  worker->busy_seconds = 0;
+
+  worker->simulation_run = simulation_run_new();
+  simulation_run_attach_data(worker->simulation_run, (void *) & worker->data);
+
+  /*
+   * Let simlib choose the event list structure as the run goes.
+   */
+
+  simulation_run_set_eventlist_adaptive(worker->simulation_run, 1);
+
+  worker->data.config = config;
+  worker->data.packets =
+    packet_table_new_in_arena(simulation_run_arena(worker->simulation_run));
+
+  config_sweep_point(config, 0, packet_arrival_rate, &p12_cutoff);
+  topology_three_switch(&worker->data.topology, packet_arrival_rate,
+			config->packet_xmt_time, p12_cutoff);
+  switches_new(worker->simulation_run);
+
+  if (!runner->keep_output) {
+    worker->discard = fopen("/dev/null", "w");
+    if (worker->discard == NULL) {
+      printf("Error: Cannot open /dev/null.\n");
+      exit(1);
+    }
+    simulation_run_set_output(worker->simulation_run, worker->discard);
+  }
+}
+
+static void
+replication_worker_free(Replication_Worker * worker)
+{
+  if (worker->discard != NULL)
+    fclose(worker->discard);
+  if (worker->queue != NULL)
+    xfree(worker->queue);
+  if (worker->lockstep != NULL)
+    lockstep_free(worker->lockstep);
+  cleanup_memory(worker->simulation_run);
+}
+
+/*
+ * Read a clock in seconds. Jobs are timed with the CPU time of the thread
+ * running them, so that a job is not charged for time its thread spent
+ * waiting for a CPU.
+ */
+
+static double
+replication_seconds(clockid_t clock)
+{
+  struct timespec now;
+
+  clock_gettime(clock, &now);
+  return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+/*
+ * The cost of a sweep point predicted from its offered load. Every packet
+ * costs about the same number of events, so a run costs about its simulated
+ * length times the total arrival rate. The run lasts until SW1 has delivered
+ * runlength packets. A switch whose utilization u is above 1 only gets 1/u of
+ * the packets offered to it through, so the SW1 packets are delivered more
+ * slowly, and the run takes longer, as the switches they go through saturate.
+ */
+
+static double
+replication_model_cost(Config_Ptr config, long int point)
+{
+  double packet_arrival_rate[3];
+  double load[3], throughput[3];
+  double p12_cutoff, utilization, delivered;
+  int s;
+
+  config_sweep_point(config, point, packet_arrival_rate, &p12_cutoff);
+
+  load[0] = packet_arrival_rate[0];
+  load[1] = packet_arrival_rate[1] + p12_cutoff * packet_arrival_rate[0];
+  load[2] = packet_arrival_rate[2] + (1 - p12_cutoff) * packet_arrival_rate[0];
+
+  for (s = 0; s < 3; s++) {
+    utilization = load[s] * config->packet_xmt_time[s];
+    throughput[s] = utilization > 1 ? 1 / utilization : 1;
+  }
+
+  delivered = packet_arrival_rate[0] * throughput[0] *
+    (p12_cutoff * throughput[1] + (1 - p12_cutoff) * throughput[2]);
+  if (delivered <= 0)
+    delivered = 1;
+
+  return config->runlength / delivered *
+    (packet_arrival_rate[0] + packet_arrival_rate[1] + packet_arrival_rate[2]);
+}
+
+/*
+ * The expected time of a job, in seconds once any job has finished. The
+ * caller holds runner->lock.
+ */
+
+static double
+replication_expected_cost(Replication_Runner * runner, long int job)
+{
+  long int point = job / runner->config->random_seed_list.count;
+
+  if (runner->measured_count[point] > 0)
+    return runner->measured_seconds[point] / runner->measured_count[point];
+  if (runner->done_model_cost > 0)
+    return runner->model_cost[point] *
+      runner->done_seconds / runner->done_model_cost;
+  return runner->model_cost[point];
+}
+
+/*
+ * Record the time a job took, refining the cost model.
+ */
+
+static void
+replication_record_cost(Replication_Runner * runner, long int job,
+			double seconds)
+{
+  long int point = job / runner->config->random_seed_list.count;
+
+  runner->measured_seconds[point] += seconds;
+  runner->measured_count[point]++;
+  runner->done_seconds += seconds;
+  runner->done_model_cost += runner->model_cost[point];
+  runner->model_version++;
+}
+
+/*
+ * The number of jobs in the task that starts at job.
+ */
+
+static long int
+replication_task_size(Replication_Runner * runner, long int job)
+{
+  long int left;
+
+  left = runner->config->random_seed_list.count -
+    job % runner->config->random_seed_list.count;
+  return left < runner->lanes ? left : runner->lanes;
+}
+
+/*
+ * The expected time of the task that starts at job. The caller holds
+ * runner->lock.
+ */
+
+static double
+replication_task_cost(Replication_Runner * runner, long int job)
+{
+  return replication_task_size(runner, job) *
+    replication_expected_cost(runner, job);
+}
+
+static int
+replication_compare_cost(const void * a, const void * b)
+{
+  const Replication_Job_Cost * first = (const Replication_Job_Cost *) a;
+  const Replication_Job_Cost * second = (const Replication_Job_Cost *) b;
+
+  if (first->cost != second->cost)
+    return first->cost > second->cost ? -1 : 1;
+  return first->job < second->job ? -1 : (first->job > second->job);
+}
+
+/*
+ * Deal the tasks out to the worker queues, longest expected first. Each task
+ * goes to the worker with the least expected work so far, so every queue
+ * also runs most expensive first.
+ */
+
+static void
+replication_schedule(Replication_Runner * runner)
+{
+  Replication_Job_Cost * jobs;
+  Replication_Worker * worker;
+  double * assigned;
+  int * owner;
+  long int job, k, count, task_count;
+  int t, least;
+
+  jobs = (Replication_Job_Cost *)
+    xmalloc(runner->job_count * sizeof(Replication_Job_Cost));
+  task_count = 0;
+  for (job = 0; job < runner->job_count; job += count) {
+    count = replication_task_size(runner, job);
+    jobs[task_count].cost = replication_task_cost(runner, job);
+    jobs[task_count].job = job;
+    task_count++;
+  }
+  qsort(jobs, task_count, sizeof(Replication_Job_Cost),
+	replication_compare_cost);
+
+  assigned = (double *) xcalloc(runner->worker_count, sizeof(double));
+  owner = (int *) xmalloc(task_count * sizeof(int));
+  for (k = 0; k < task_count; k++) {
+    least = 0;
+    for (t = 1; t < runner->worker_count; t++)
+      if (assigned[t] < assigned[least])
+	least = t;
+    assigned[least] += jobs[k].cost;
+    owner[k] = least;
+    runner->workers[least].tail++;
+  }
+
+  for (t = 0; t < runner->worker_count; t++) {
+    worker = &runner->workers[t];
+    worker->queue = (Replication_Job_Cost *)
+      xmalloc((worker->tail + 1) * sizeof(Replication_Job_Cost));
+    worker->tail = 0;
+    worker->remaining = assigned[t];
+    worker->model_version = runner->model_version;
+  }
+  for (k = 0; k < task_count; k++) {
+    worker = &runner->workers[owner[k]];
+    worker->queue[worker->tail++] = jobs[k];
+  }
+
+  xfree(owner);
+  xfree(assigned);
+  xfree(jobs);
+}
+
+/*
+ * Take the task at the head of a worker's queue, which must not be empty.
+ * If the cost model has changed since the queue was sorted, its tasks are
+ * costed again and sorted first, so the task taken is the most expensive one
+ * by the model as it stands. This can differ from the order the tasks were
+ * dealt in. The caller holds the worker's queue_lock.
+ */
+
+static long int
+replication_queue_take(Replication_Runner * runner,
+		       Replication_Worker * worker)
+{
+  Replication_Job_Cost * task;
+  long int k;
+  int stale;
+
+  pthread_mutex_lock(&runner->lock);
+  stale = worker->model_version != runner->model_version;
+  if (stale) {
+    worker->remaining = 0;
+    for (k = worker->head; k < worker->tail; k++) {
+      worker->queue[k].cost = replication_task_cost(runner,
+						    worker->queue[k].job);
+      worker->remaining += worker->queue[k].cost;
+    }
+    worker->model_version = runner->model_version;
+  }
+  pthread_mutex_unlock(&runner->lock);
+
+  if (stale)
+    qsort(worker->queue + worker->head, worker->tail - worker->head,
+	  sizeof(Replication_Job_Cost), replication_compare_cost);
+
+  task = &worker->queue[worker->head++];
+  worker->remaining -= task->cost;
+  return task->job;
+}
+
+/*
+ * Get the next task for a worker: the head of its own queue, or else the
+ * head of the queue of the worker with the most expected work left. Only the
+ * worker's own queue is locked unless it has to steal, and then only one
+ * other queue at a time. Returns 0 when every queue is empty.
+ */
+
+static int
+replication_next_job(Replication_Worker * worker, long int * job)
+{
+  Replication_Runner * runner = worker->runner;
+  Replication_Worker * victim, * other;
+  double most;
+  int t, found;
+
+  pthread_mutex_lock(&worker->queue_lock);
+  found = worker->head < worker->tail;
+  if (found)
+    *job = replication_queue_take(runner, worker);
+  pthread_mutex_unlock(&worker->queue_lock);
+
+  /*
+   * Tasks are never added to a queue once the workers have started, so if
+   * every other queue is seen empty there is nothing left to steal. A victim
+   * that is emptied between being chosen and being locked is chosen again.
+   */
+
+  while (!found) {
+    victim = NULL;
+    most = 0;
+    for (t = 0; t < runner->worker_count; t++) {
+      if (t == worker->id)
+	continue;
+      other = &runner->workers[t];
+      pthread_mutex_lock(&other->queue_lock);
+      if (other->head < other->tail &&
+	  (victim == NULL || other->remaining > most)) {
+	most = other->remaining;
+	victim = other;
+      }
+      pthread_mutex_unlock(&other->queue_lock);
+    }
+    if (victim == NULL)
+      break;
+
+    pthread_mutex_lock(&victim->queue_lock);
+    found = victim->head < victim->tail;
+    if (found) {
+      *job = replication_queue_take(runner, victim);
+      worker->jobs_stolen++;
+    }
+    pthread_mutex_unlock(&victim->queue_lock);
+  }
+
+  return found;
+}
+
+/*
+ * Set a worker up for the sweep point of job. The simulation_run, packet
+ * table and switches are reset rather than rebuilt.
+ */
+
+static void
+replication_worker_prepare(Replication_Worker * worker, long int job)
+{
+  Simulation_Run_Ptr simulation_run = worker->simulation_run;
+  Simulation_Run_Data_Ptr data = &worker->data;
+  Config_Ptr config = worker->runner->config;
+  double packet_arrival_rate[3];
+  double p12_cutoff;
+
+  config_sweep_point(config, job / config->random_seed_list.count,
+		     packet_arrival_rate, &p12_cutoff);
+  topology_three_switch(&data->topology, packet_arrival_rate,
+			config->packet_xmt_time, p12_cutoff);
+#ifdef STATIC_TOPOLOGY
+  static_topology_check(&data->topology);
+#endif
+
+  /*
+   * Bring the simulation_run, packet table and switches back to their
+   * initial state for this replication.
+   */
+
+  simulation_run_reset(simulation_run);
+  packet_table_reset(data->packets);
+  switches_reset(simulation_run);
+}
+
+/*
+ * Run one job on a worker. The run starts with the first packet arrival
+ * event at each switch that has a source. The totals of the run are returned
+ * in result.
+ */
+
+static void
+replication_worker_run(Replication_Worker * worker, long int job,
+		       Replication_Result * result)
+{
+  Simulation_Run_Ptr simulation_run = worker->simulation_run;
+  Simulation_Run_Data_Ptr data = &worker->data;
+  Config_Ptr config = worker->runner->config;
+  Switch_Ptr sw;
+  int s;
+
+  replication_worker_prepare(worker, job);
+  data->random_seed = (unsigned)
+    config->random_seed_list.values[job % config->random_seed_list.count];
+
+  /* 
+   * Set the random number generator seed for this run.
+   */
+
+  simulation_run_random_initialize(simulation_run, data->random_seed);
+
+  /* 
+   * Schedule the initial packet arrivals for the current clock time (= 0).
+   */
+
+#ifdef STATIC_TOPOLOGY
+  static_topology_start(simulation_run);
+#else
+  for (s = 0; s < data->topology.switch_count; s++) {
+    sw = &data->switches[s];
+    if (sw->config->packet_arrival_rate > 0)
+      schedule_packet_arrival_event(simulation_run,
+	    simulation_run_get_sim_time(simulation_run), sw);
+  }
+#endif
+
+  /* 
+   * Execute events until we are finished. 
+   */
+
+#if defined(STATIC_TOPOLOGY)
+  run_events_static(simulation_run, run_length_reached, (void *) data);
+#elif defined(TYPED_EVENT_DISPATCH)
+  run_events_by_kind(simulation_run, run_length_reached, (void *) data);
+#else
+  simulation_run_run_until(simulation_run, -1.0, 0, run_length_reached,
+			   (void *) data);
+#endif
+
+  /*
+   * Output results.
+   */
+
+  output_results(simulation_run);
+
+  result->switch_count = data->topology.switch_count;
+  result->totals = (Switch_Totals *)
+    xmalloc(result->switch_count * sizeof(Switch_Totals));
+
+  for (s = 0; s < data->topology.switch_count; s++) {
+    sw = &data->switches[s];
+    result->totals[s].packet_arrival_rate = sw->config->packet_arrival_rate;
+    result->totals[s].arrival_count = sw->arrival_count;
+    result->totals[s].number_of_packets_processed =
+      sw->number_of_packets_processed;
+    result->totals[s].accumulated_delay = sw->accumulated_delay;
+    result->totals[s].random_seed = data->random_seed;
+  }
+}
+
+/*
+ * Run the task of count jobs starting at job on a worker's lockstep engine,
+ * one lane per seed. Nothing is printed.
+ */
+
+static void
+replication_worker_run_lockstep(Replication_Worker * worker, long int job,
+				long int count, Replication_Result * results)
+{
+  Simulation_Run_Data_Ptr data = &worker->data;
+  Config_Ptr config = worker->runner->config;
+  Switch_Totals * totals[LOCKSTEP_MAX_LANES];
+  unsigned seeds[LOCKSTEP_MAX_LANES];
+  long int k;
+
+  replication_worker_prepare(worker, job);
+
+  for (k = 0; k < count; k++) {
+    seeds[k] = (unsigned)
+      config->random_seed_list.values[(job + k) %
+				      config->random_seed_list.count];
+    results[k].switch_count = data->topology.switch_count;
+    results[k].totals = (Switch_Totals *)
+      xmalloc(results[k].switch_count * sizeof(Switch_Totals));
+    totals[k] = results[k].totals;
+  }
+
+  lockstep_run(worker->lockstep, data, seeds, (int) count, totals);
+}
+
+/*
+ * Run the task starting at job, returning its number of jobs.
+ */
+
+static long int
+replication_worker_run_task(Replication_Worker * worker, long int job)
+{
+  Replication_Runner * runner = worker->runner;
+  long int count;
+
+  count = replication_task_size(runner, job);
+  if (worker->lockstep != NULL)
+    replication_worker_run_lockstep(worker, job, count, &runner->results[job]);
+  else
+    replication_worker_run(worker, job, &runner->results[job]);
+  return count;
+}
+
+/*
+ * The worker thread. It runs tasks from its own queue, then steals, until
+ * there are none left, with the output of each going to the job's buffer.
+ * The time each task takes is shared out among its jobs and fed back into
+ * the cost model.
+ */
+
+static void *
+replication_worker_thread(void * ptr)
+{
+  Replication_Worker * worker = (Replication_Worker *) ptr;
+  Replication_Runner * runner = worker->runner;
+  Replication_Result * result;
+  FILE * output;
+  double start, seconds;
+  long int job, count, k;
+
+  while (replication_next_job(worker, &job)) {
+    result = &runner->results[job];
+    start = replication_seconds(CLOCK_THREAD_CPUTIME_ID);
+    output = NULL;
+    if (runner->keep_output && worker->lockstep == NULL) {
+      output = open_memstream(&result->output, &result->output_size);
+      if (output == NULL) {
+	printf("Error: Cannot create the output buffer of a replication.\n");
+	exit(1);
+      }
+      simulation_run_set_output(worker->simulation_run, output);
+    }
+
+    count = replication_worker_run_task(worker, job);
+
+    if (output != NULL)
+      fclose(output);
+
+    seconds = replication_seconds(CLOCK_THREAD_CPUTIME_ID) - start;
+    worker->busy_seconds += seconds;
+    worker->jobs_run += count;
+
+    pthread_mutex_lock(&runner->lock);
+    for (k = 0; k < count; k++) {
+      replication_record_cost(runner, job + k, seconds / count);
+      result[k].done = 1;
+    }
+    pthread_cond_broadcast(&runner->job_done);
+    pthread_mutex_unlock(&runner->lock);
+  }
+
+  return NULL;
+}
+
+/*
+ * Hand a finished job back: print its output and pass its totals to the
+ * commit function.
+ */
+
+static void
+replication_commit(Replication_Result * result, long int job,
+		   Replication_Commit commit, void * ctx)
+{
+  if (result->output != NULL) {
+    fwrite(result->output, 1, result->output_size, stdout);
+    free(result->output);   /* Allocated by open_memstream(). */
+    result->output = NULL;
+  }
+
+  if (commit != NULL)
+    commit(job, result->switch_count, result->totals, ctx);
+
+  xfree(result->totals);
+  result->totals = NULL;
+}
+
+/******************************************************************************/
+
+/*
+ * Print how busy each worker was, as the CPU time of its jobs over the wall
+ * time of the sweep.
+ */
+
+static void
+replication_report(Replication_Runner * runner, double wall_seconds)
+{
+  Replication_Worker * worker;
+  int t;
+
+  printf("Worker utilization (%d threads, %.3f sec):\n",
+	 runner->worker_count, wall_seconds);
+  printf("worker  jobs  stolen  busy sec  utilization\n");
+  for (t = 0; t < runner->worker_count; t++) {
+    worker = &runner->workers[t];
+    printf("%6d  %4ld  %6ld  %8.3f  %10.1f%%\n", t, worker->jobs_run,
+	   worker->jobs_stolen, worker->busy_seconds,
+	   wall_seconds > 0 ? 100 * worker->busy_seconds / wall_seconds : 0);
+  }
+}
+
+/*
+ * Run every job of the sweep on thread_count threads. See replication.h.
+ */
+
+void
+replication_run_all(Config_Ptr config, int thread_count, int keep_output,
+		    Replication_Commit commit, void * ctx)
+{
+  Replication_Runner runner;
+  Replication_Result * result;
+  double start, job_start;
+  long int job, point_count, task_count, count, k;
+  int t;
+
+  start = replication_seconds(CLOCK_MONOTONIC);
+
+  point_count = config_sweep_count(config);
+  runner.config = config;
+  runner.keep_output = keep_output;
+  runner.lanes = config->lockstep > 1 ? config->lockstep : 1;
+  runner.job_count = point_count * config->random_seed_list.count;
+  runner.results = (Replication_Result *)
+    xcalloc(runner.job_count, sizeof(Replication_Result));
+
+  runner.model_cost = (double *) xmalloc(point_count * sizeof(double));
+  for (job = 0; job < point_count; job++)
+    runner.model_cost[job] = replication_model_cost(config, job);
+  runner.measured_seconds = (double *) xcalloc(point_count, sizeof(double));
+  runner.measured_count = (long int *) xcalloc(point_count, sizeof(long int));
+  runner.done_model_cost = 0;
+  runner.done_seconds = 0;
+  runner.model_version = 0;
+
+  task_count = point_count *
+    ((config->random_seed_list.count + runner.lanes - 1) / runner.lanes);
+  if (thread_count > task_count)
+    thread_count = task_count;
+  if (thread_count < 1)
+    thread_count = 1;
+
+  runner.worker_count = thread_count;
+  runner.workers = (Replication_Worker *)
+    xcalloc(thread_count, sizeof(Replication_Worker));
+  for (t = 0; t < thread_count; t++) {
+    replication_worker_init(&runner.workers[t], &runner);
+    runner.workers[t].id = t;
+  }
+
+  if (thread_count == 1) {
+
+    /*
+     * Run the tasks here, in order, printing straight to stdout.
+     */
+
+    for (job = 0; job < runner.job_count; job += count) {
+      job_start = replication_seconds(CLOCK_THREAD_CPUTIME_ID);
+      count = replication_worker_run_task(&runner.workers[0], job);
+      runner.workers[0].busy_seconds +=
+	replication_seconds(CLOCK_THREAD_CPUTIME_ID) - job_start;
+      runner.workers[0].jobs_run += count;
+      for (k = 0; k < count; k++)
+	replication_commit(&runner.results[job + k], job + k, commit, ctx);
+    }
+
+  } else {
+
+    pthread_mutex_init(&runner.lock, NULL);
+    pthread_cond_init(&runner.job_done, NULL);
+    for (t = 0; t < thread_count; t++)
+      pthread_mutex_init(&runner.workers[t].queue_lock, NULL);
+
+    replication_schedule(&runner);
+
+    for (t = 0; t < thread_count; t++)
+      if (pthread_create(&runner.workers[t].thread, NULL,
+			 replication_worker_thread,
+			 (void *) & runner.workers[t]) != 0) {
+	printf("Error: Cannot create replication thread %d.\n", t);
+	exit(1);
+      }
+
+    /*
+     * Hand the jobs back in order as they finish.
+     */
+
+    for (job = 0; job < runner.job_count; job++) {
+      result = &runner.results[job];
+      pthread_mutex_lock(&runner.lock);
+      while (!result->done)
+	pthread_cond_wait(&runner.job_done, &runner.lock);
+      pthread_mutex_unlock(&runner.lock);
+      replication_commit(result, job, commit, ctx);
+    }
+
+    for (t = 0; t < thread_count; t++)
+      pthread_join(runner.workers[t].thread, NULL);
+
+    for (t = 0; t < thread_count; t++)
+      pthread_mutex_destroy(&runner.workers[t].queue_lock);
+    pthread_cond_destroy(&runner.job_done);
+    pthread_mutex_destroy(&runner.lock);
+  }
+
+  if (config->worker_report)
+    replication_report(&runner, replication_seconds(CLOCK_MONOTONIC) - start);
+
+  for (t = 0; t < thread_count; t++)
+    replication_worker_free(&runner.workers[t]);
+
+  xfree(runner.workers);
+  xfree(runner.measured_count);
+  xfree(runner.measured_seconds);
+  xfree(runner.model_cost);
+  xfree(runner.results);
+}
+
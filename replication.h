@@ -0,0 +1,87 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _REPLICATION_H_
+#define _REPLICATION_H_
+
+/******************************************************************************/
+
+#include "main.h"
+
+/******************************************************************************/
+
+/*
+ * A replication is one run of one sweep point with one random seed. The jobs
+ * of a sweep are numbered sweep point by sweep point, and by seed within each
+ * point, so job j is seed j % seed count of sweep point j / seed count.
+ *
+ * replication_run_all() runs every job of the sweep on a pool of threads.
+ * Each worker thread has its own Simulation_Run, Simulation_Run_Data and
+ * random number stream, so the replications share nothing but the Config.
+ *
+ * Sweep points differ a lot in cost, since the runs get longer as a switch
+ * nears saturation. The jobs are dealt out longest expected first, by a cost
+ * model based on the offered load of each switch, to one queue per worker.
+ * The time each job takes refines the model, so the remaining seeds of a
+ * sweep point are expected to take as long as those already run. Each queue
+ * has its own lock and is kept sorted by the refined model, so a worker
+ * always runs the job at its head, the one the model expects to take
+ * longest. A worker that runs out of jobs steals the head of the queue of the
+ * worker with the most expected work left, and only then locks another
+ * worker's queue. If config->worker_report is set, the jobs, steals and busy
+ * time of each worker are printed at the end.
+ *
+ * Whatever a replication prints goes to a buffer of its own. The calling
+ * thread hands the jobs back in job order, printing each job's buffer and
+ * passing its Switch_Totals to the commit function. The output and the
+ * totals therefore do not depend on the number of threads. With one thread,
+ * the jobs run on the calling thread and print straight to stdout. If
+ * keep_output is 0, what the replications print is thrown away.
+ *
+ * If config->lockstep is 2 or more, the seeds of each sweep point are run
+ * config->lockstep at a time by the lockstep engine (lockstep.h), and those
+ * jobs are scheduled as one task of their summed expected cost. The engine
+ * gives the same totals as the event engine, but prints nothing.
+ *
+ * A worker reuses its storage from job to job, so the memory figures that a
+ * replication prints, such as the arena peak, depend on which worker ran it
+ * and what it ran before. Everything else is the same as with one thread.
+ */
+
+typedef void (* Replication_Commit)(long int, int, Switch_Totals *, void *);
+
+/******************************************************************************/
+
+/*
+ * Function prototypes
+ */
+
+void
+replication_run_all(Config_Ptr, int, int, Replication_Commit, void *);
+
+/******************************************************************************/
+
+#endif /* replication.h */
+
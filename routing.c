@@ -0,0 +1,145 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include "trace.h"
+#include "main.h"
+#include "routing.h"
+
+/******************************************************************************/
+
+/*
+ * Build the routing table of a switch from its next hops. This is done before
+ * each run, so a change to the probabilities between runs takes effect at the
+ * next one. Alias tables are built with Vose's method, which takes time
+ * proportional to the number of next hops.
+ */
+
+void
+routing_table_build(Routing_Table * table, Switch_Config * config)
+{
+  int small[MAX_NEXT_HOPS], large[MAX_NEXT_HOPS];
+  double scaled[MAX_NEXT_HOPS];
+  int small_count = 0, large_count = 0;
+  int k, s, l;
+  double sum;
+
+  table->count = config->next_hop_count;
+  table->use_alias = config->next_hop_count > ROUTING_SCAN_MAX_HOPS;
+
+  sum = 0.0;
+  for (k=0; k<config->next_hop_count; k++) {
+    table->next_hop[k] = config->next_hop[k];
+    sum += config->next_hop_probability[k];
+    table->cutoff[k] = sum;
+  }
+
+  if (!table->use_alias)
+    return;
+
+  /*
+   * Scale the probabilities so that they average 1. Each column with less
+   * than 1 is filled up from a column with more than 1, which becomes its
+   * alias.
+   */
+
+  for (k=0; k<table->count; k++) {
+    scaled[k] = config->next_hop_probability[k] * table->count / sum;
+    if (scaled[k] < 1.0)
+      small[small_count++] = k;
+    else
+      large[large_count++] = k;
+  }
+
+  while (small_count > 0 && large_count > 0) {
+    s = small[--small_count];
+    l = large[--large_count];
+
+    table->cutoff[s] = scaled[s];
+    table->alias[s] = l;
+
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0)
+      small[small_count++] = l;
+    else
+      large[large_count++] = l;
+  }
+
+  /* Any columns left over are full, up to rounding error. */
+
+  while (large_count > 0) {
+    l = large[--large_count];
+    table->cutoff[l] = 1.0;
+    table->alias[l] = l;
+  }
+  while (small_count > 0) {
+    s = small[--small_count];
+    table->cutoff[s] = 1.0;
+    table->alias[s] = s;
+  }
+}
+
+/*
+ * Draw the next hop for a packet. A uniform random number is only drawn when
+ * there is more than one next hop.
+ */
+
+int
+routing_table_choose(Simulation_Run_Ptr simulation_run, Routing_Table * table)
+{
+  return routing_table_choose_count(simulation_run, table, table->count);
+}
+
+/*
+ * Get the next hop given by a uniform random number in (0, 1). For an alias
+ * table, the integer part of the scaled number picks the column and the
+ * fractional part is compared with its cutoff, so this takes constant time.
+ *
+ * The uniform generator takes 32766 values, and each of them gives exactly
+ * one column and fraction. A column therefore gets about 32767/count of the
+ * values, and its cutoff is resolved to one of them. Each next hop comes out
+ * within about 1/32767 of its probability for every column it fills, which is
+ * the same resolution a scan of the cumulative probabilities has.
+ */
+
+int
+routing_table_pick(Routing_Table * table, double rand_hop)
+{
+  double x;
+  int k;
+
+  if (table->use_alias) {
+    x = rand_hop * table->count;
+    k = (int) x;
+    if (k >= table->count)
+      k = table->count - 1;
+    if (x - k < table->cutoff[k])
+      return table->next_hop[k];
+    return table->next_hop[table->alias[k]];
+  }
+
+  return routing_table_scan(table, rand_hop, table->count);
+}
+
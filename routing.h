@@ -0,0 +1,87 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _ROUTING_H_
+#define _ROUTING_H_
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include "trace.h"
+#include "main.h"
+
+/******************************************************************************/
+
+/*
+ * Function prototypes
+ */
+
+void routing_table_build(Routing_Table *, Switch_Config *);
+int routing_table_choose(Simulation_Run_Ptr, Routing_Table *);
+int routing_table_pick(Routing_Table *, double);
+
+/*
+ * Scan the cumulative probabilities of a table with count next hops.
+ */
+
+static inline int
+routing_table_scan(Routing_Table * table, double rand_hop, const int count)
+{
+  int k;
+
+  for (k=0; k<count-1; k++)
+    if (rand_hop <= table->cutoff[k])
+      break;
+  return table->next_hop[k];
+}
+
+/*
+ * routing_table_choose() for a table with count next hops. When count is a
+ * constant, as it is for a static topology, the choice between no draw, a
+ * scan and an alias lookup is made when this is compiled, and a scan is
+ * unrolled.
+ */
+
+static inline int
+routing_table_choose_count(Simulation_Run_Ptr simulation_run,
+			   Routing_Table * table, const int count)
+{
+  double rand_hop;
+
+  if (count == 1)
+    return table->next_hop[0];
+
+  rand_hop = simulation_run_uniform_generator(simulation_run);
+  TRACE(fprintf(simulation_run_output(simulation_run), "rand_hop %f\n", rand_hop);)
+
+  if (count > ROUTING_SCAN_MAX_HOPS)
+    return routing_table_pick(table, rand_hop);
+  return routing_table_scan(table, rand_hop, count);
+}
+
+/******************************************************************************/
+
+#endif /* routing.h */
+
@@ -22,13 +22,39 @@
 
 /*******************************************************************************/
 
+/*
+ * MAP_ANONYMOUS and madvise() are not C99 or POSIX.
+ */
+
+#if defined(SIMLIB_ARENA_HUGEPAGES) && defined(__linux__)
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "trace.h"
 #include "simlib.h"
 
+#if defined(SIMLIB_ARENA_HUGEPAGES) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/*******************************************************************************/
+
+/*
+ * Slot positions. An event slot that is on the heap holds its heap index in
+ * the position array, and one that is on the radix heap holds its bucket
+ * number. Otherwise the position says where the slot is.
+ */
+
+#define NO_SLOT -1
+#define EVENT_SLOT_FREE -1
+#define EVENT_SLOT_NOW -2
+#define EVENT_SLOT_LISTED -3
+
 /*******************************************************************************/
 
 /*
@@ -36,64 +62,238 @@
  */
 
 static Clock_Ptr
-clock_new(void);
+clock_new(Arena_Ptr);
 
 static void
-simulation_run_set_time (Simulation_Run_Ptr, double);
+simulation_run_set_time (Simulation_Run_Ptr, Sim_Time);
 
 static Eventlist_Ptr
-eventlist_new(void);
+eventlist_new(Arena_Ptr);
+
+static void
+eventlist_reset(Eventlist_Ptr);
+
+static void
+eventlist_grow(Eventlist_Ptr, int);
+
+static int
+eventlist_slot_new(Eventlist_Ptr);
+
+static void
+eventlist_slot_free(Eventlist_Ptr, int);
 
 static Eventlist_Ptr
 simulation_run_get_eventlist(Simulation_Run_Ptr);
 
-static Event_Container_Ptr
+static int
 simulation_run_get_event(Simulation_Run_Ptr);
 
+static Event_Handle
+simulation_run_schedule(Simulation_Run_Ptr, void (*)(Simulation_Run_Ptr, void *),
+			void *, int, const char *, Sim_Time);
+
+static void
+simulation_run_take_event(Simulation_Run_Ptr, int, Event_Payload *);
+
+static void
+simulation_run_dispatch_event(Simulation_Run_Ptr, int);
+
+static int
+event_precedes(Eventlist_Ptr, int, int);
+
+static int
+event_key_precedes(Event_Key *, Event_Key *);
+
+static void
+eventlist_insert(Eventlist_Ptr, int);
+
+static void
+eventlist_remove(Eventlist_Ptr, int);
+
+static int
+eventlist_remove_front(Eventlist_Ptr);
+
+static int
+eventlist_front(Eventlist_Ptr);
+
+static void
+eventlist_now_insert(Eventlist_Ptr, int);
+
+static void
+eventlist_now_remove(Eventlist_Ptr, int);
+
+static void
+eventlist_list_insert(Eventlist_Ptr, int);
+
+static void
+eventlist_list_remove(Eventlist_Ptr, int);
+
+static void
+eventlist_heap_insert(Eventlist_Ptr, int);
+
+static void
+eventlist_heap_remove(Eventlist_Ptr, int);
+
+static void
+eventlist_heap_sift_up(Eventlist_Ptr, int);
+
+static void
+eventlist_heap_sift_down(Eventlist_Ptr, int);
+
+static long long
+eventlist_calendar_day(Eventlist_Ptr, Sim_Time);
+
+static void
+eventlist_calendar_insert(Eventlist_Ptr, int);
+
+static void
+eventlist_calendar_place(Eventlist_Ptr, int);
+
+static void
+eventlist_calendar_remove(Eventlist_Ptr, int);
+
+static int
+eventlist_calendar_front(Eventlist_Ptr);
+
+static int
+eventlist_calendar_remove_front(Eventlist_Ptr);
+
+static void
+eventlist_calendar_resize(Eventlist_Ptr, int);
+
+static void
+eventlist_calendar_reserve(Eventlist_Ptr, int);
+
+static uint64_t
+eventlist_radix_key(Sim_Time);
+
+static int
+eventlist_radix_bucket(Eventlist_Ptr, uint64_t);
+
+static void
+eventlist_radix_insert(Eventlist_Ptr, int);
+
+static void
+eventlist_radix_place(Eventlist_Ptr, int);
+
+static void
+eventlist_radix_remove(Eventlist_Ptr, int);
+
+static int
+eventlist_radix_front(Eventlist_Ptr);
+
+static int
+eventlist_radix_remove_front(Eventlist_Ptr);
+
+static void
+eventlist_adapt(Eventlist_Ptr, int, Sim_Time, long int, FILE *);
+
+static Eventlist_Type
+eventlist_adaptive_choice(Eventlist_Ptr);
+
+static void
+eventlist_migrate(Eventlist_Ptr, Eventlist_Type, Sim_Time);
+
+static int
+event_heap_entry_compare(const void *, const void *);
+
+static void
+fifoqueue_resize(Fifoqueue_Ptr, int);
+
+static Arena_Block *
+arena_block_new(size_t);
+
+static void
+arena_block_free(Arena_Block *);
+
 #ifdef TRACE_ON /* This is only used when tracing is active. */
-static void event_print_type(Event);
+static void event_print_type(FILE *, const char *);
 #endif /* TRACE_ON */
 
 /******************************************************************************/
 
 /*
  * Create a new simulation_run. The simulation_run will include a clock, an
- * event list, and a data pointer to simulation_run data.
+ * event list, and a data pointer to simulation_run data. It is created in a
+ * new arena, which everything else that belongs to it is allocated from.
  */
 
 Simulation_Run_Ptr
 simulation_run_new(void)
 {
   Simulation_Run_Ptr new_simulation_run;
-
-  new_simulation_run = (Simulation_Run_Ptr) xmalloc(sizeof(Simulation_Run));
-  new_simulation_run->eventlist = eventlist_new();
-  new_simulation_run->clock = clock_new();
+  Arena_Ptr arena;
+
+  arena = arena_new();
+  new_simulation_run = (Simulation_Run_Ptr)
+    arena_alloc(arena, sizeof(Simulation_Run));
+  new_simulation_run->arena = arena;
+  new_simulation_run->eventlist = eventlist_new(arena);
+  new_simulation_run->clock = clock_new(arena);
+  new_simulation_run->rand_stream = (Rand_Stream_Ptr)
+    arena_alloc(arena, sizeof(Rand_Stream));
+  rand_stream_initialize(new_simulation_run->rand_stream, 1);
+  new_simulation_run->next_event_id = 1;
+  new_simulation_run->events_executed = 0;
+  new_simulation_run->predicate_interval = 1;
   new_simulation_run->data = NULL;
+  new_simulation_run->output = stdout;
   return new_simulation_run;
 }
 
+/*
+ * Return a simulation_run to the state it had when it was created, so that it
+ * can be used for another run without being rebuilt. The clock goes back to
+ * 0, any scheduled events are dropped, event ids start again at 1 and the
+ * random number stream is reset to its initial seed. The event storage and
+ * everything else allocated from its arena are kept. So are the data pointer,
+ * the predicate interval and the event list settings. Handles to events from
+ * before the reset must not be used.
+ */
+
+void
+simulation_run_reset(Simulation_Run_Ptr simulation_run)
+{
+  eventlist_reset(simulation_run->eventlist);
+  simulation_run->clock->time = 0;
+  rand_stream_initialize(simulation_run->rand_stream, 1);
+  simulation_run->next_event_id = 1;
+  simulation_run->events_executed = 0;
+}
+
 /*
  * When a new simulation_run is defined and created, a clock is created which is
  * part of the simulation_run.
  */
  
 static
-Clock_Ptr clock_new (void)
+Clock_Ptr clock_new (Arena_Ptr arena)
 {
   Clock_Ptr new_clock;
 
-  new_clock = (Clock_Ptr) xmalloc(sizeof(Clock));
-  new_clock->time = 0.0;
+  new_clock = (Clock_Ptr) arena_alloc(arena, sizeof(Clock));
+  new_clock->time = 0;
   return new_clock;
 }
 
 /*
- * Given a pointer to a simulation_run, find out the current clock time.
+ * Given a pointer to a simulation_run, find out the current clock time in
+ * seconds.
  */
 
 double
 simulation_run_get_time (Simulation_Run_Ptr this_simulation_run)
+{
+  return SIM_TIME_TO_SECONDS(this_simulation_run->clock->time);
+}
+
+/*
+ * Given a pointer to a simulation_run, find out the current clock time as a
+ * Sim_Time.
+ */
+
+Sim_Time
+simulation_run_get_sim_time (Simulation_Run_Ptr this_simulation_run)
 {
   return this_simulation_run->clock->time;
 }
@@ -104,7 +304,7 @@ simulation_run_get_time (Simulation_Run_Ptr this_simulation_run)
 
 static
 void simulation_run_set_time (Simulation_Run_Ptr this_simulation_run,
-			      double time)
+			      Sim_Time time)
 {
   this_simulation_run->clock->time = time;
 }
@@ -129,265 +329,1630 @@ simulation_run_set_data (Simulation_Run_Ptr this_simulation_run, void * data)
   this_simulation_run->data = data;
 }
 
+/*
+ * The stream that trace and results of a simulation_run are written to. It is
+ * stdout unless changed, for example to keep the output of simulation_runs on
+ * different threads apart. Error messages still go to stdout.
+ */
+
+FILE *
+simulation_run_output(Simulation_Run_Ptr this_simulation_run)
+{
+  return this_simulation_run->output;
+}
+
+void
+simulation_run_set_output(Simulation_Run_Ptr this_simulation_run,
+			  FILE * output)
+{
+  this_simulation_run->output = output;
+}
+
+
+/*
+ * Select the event list structure used by a simulation_run. This must be done
+ * before any events have been scheduled.
+ */
+
+void
+simulation_run_set_eventlist_type(Simulation_Run_Ptr simulation_run,
+				  Eventlist_Type type)
+{
+  Eventlist_Ptr event_list;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  if (event_list->size + event_list->now_size != 0) {
+    printf("Error: Cannot change the event list type while events ");
+    printf("are scheduled.\n");
+    exit(1);
+  }
+  event_list->type = type;
+  event_list->configured_type = type;
+}
+
+/*
+ * Get the event list structure that is currently in use.
+ */
+
+Eventlist_Type
+simulation_run_eventlist_type(Simulation_Run_Ptr simulation_run)
+{
+  return simulation_run_get_eventlist(simulation_run)->type;
+}
+
+/*
+ * Turn adaptive selection of the event list structure on (nonzero) or off.
+ * This can be done at any time. The structure in use when it is turned off is
+ * kept.
+ */
+
+void
+simulation_run_set_eventlist_adaptive(Simulation_Run_Ptr simulation_run,
+				      int adaptive)
+{
+  Eventlist_Ptr event_list;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  event_list->adaptive = adaptive;
+  event_list->adaptive_inserts = 0;
+  event_list->adaptive_back_inserts = 0;
+  event_list->adaptive_scan = 0;
+}
+
+/*
+ * Get the number of times that adaptive selection has changed the event list
+ * structure, and the details of each change in the order they happened.
+ */
+
+int
+simulation_run_eventlist_switch_count(Simulation_Run_Ptr simulation_run)
+{
+  return simulation_run_get_eventlist(simulation_run)->switch_count;
+}
+
+Eventlist_Switch
+simulation_run_eventlist_switch(Simulation_Run_Ptr simulation_run, int index)
+{
+  Eventlist_Ptr event_list;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  if (index < 0 || index >= event_list->switch_count) {
+    printf("Error: There is no event list switch %d.\n", index);
+    exit(1);
+  }
+  return event_list->switches[index];
+}
+
+/*
+ * Get a printable name for an event list structure.
+ */
+
+const char *
+eventlist_type_name(Eventlist_Type type)
+{
+  switch (type) {
+  case EVENTLIST_HEAP:
+    return "heap";
+  case EVENTLIST_CALENDAR:
+    return "calendar";
+  case EVENTLIST_RADIX:
+    return "radix";
+  default:
+    return "list";
+  }
+}
 
 /*
  * This function makes an entry on the event list. It must be passed the
  * simulation_run, the type of event, and the time that the event is to occur. An
  * event_contents pointer can also be passed which can be recovered when the
- * event function is called. The event list itself is a double linked list.
+ * event function is called. A handle to the scheduled event is returned.
  */
 
-long int
+Event_Handle
 simulation_run_schedule_event(Simulation_Run_Ptr simulation_run,
 			      Event new_event, double new_event_time)
 {
-  Event_Container_Ptr current_container, new_container, 
-    next_container;
+  return simulation_run_schedule_event_sim_time(simulation_run, new_event,
+				SIM_TIME_FROM_SECONDS(new_event_time));
+}
+
+/*
+ * Schedule an event for a time given as a Sim_Time.
+ */
+
+Event_Handle
+simulation_run_schedule_event_sim_time(Simulation_Run_Ptr simulation_run,
+				       Event new_event, Sim_Time new_event_time)
+{
+  return simulation_run_schedule(simulation_run, new_event.function,
+				 new_event.attachment, EVENT_KIND_FUNCTION,
+				 new_event.description, new_event_time);
+}
+
+/*
+ * Schedule an event by kind rather than by event function. The kind must be
+ * greater than 0. The payload is returned along with the kind by
+ * simulation_run_next_event. The description is only used for tracing and
+ * error messages.
+ */
+
+Event_Handle
+simulation_run_schedule_kind_event(Simulation_Run_Ptr simulation_run,
+				   int kind, uint32_t payload,
+				   const char * description,
+				   Sim_Time new_event_time)
+{
+  if (kind <= EVENT_KIND_FUNCTION) {
+    printf("Error: Event kind %d is not greater than 0.\n", kind);
+    exit(1);
+  }
+  return simulation_run_schedule(simulation_run, NULL,
+				 (void *) (uintptr_t) payload, kind,
+				 description, new_event_time);
+}
+
+/*
+ * Put an event with the given function, attachment and kind on the event
+ * list.
+ */
+
+static Event_Handle
+simulation_run_schedule(Simulation_Run_Ptr simulation_run,
+			void (* function)(Simulation_Run_Ptr, void *),
+			void * attachment, int kind, const char * description,
+			Sim_Time new_event_time)
+{
+  Event_Payload * payload;
+  Event_Handle handle;
+  int slot;
 
-  double current_time;
+  Sim_Time current_time;
   Eventlist_Ptr event_list;
-  static long int event_id = 1;
+  long int event_id;
 
-  current_time = simulation_run_get_time(simulation_run);
+  event_id = simulation_run->next_event_id;
+  current_time = simulation_run_get_sim_time(simulation_run);
   event_list = simulation_run_get_eventlist(simulation_run);
 
   //TRACE(printf("MM_debug in simulation_run_schedule_event.\n");)
-  TRACE(printf("At %.3f : ", current_time);)
-  TRACE(printf("  event_id %d : ", event_id);)
-  TRACE(event_print_type(new_event);)
-  TRACE(printf("Scheduled for  %.3f \n", new_event_time);)
+  TRACE(fprintf(simulation_run->output, "At %.3f : ", SIM_TIME_TO_SECONDS(current_time));)
+  TRACE(fprintf(simulation_run->output, "  event_id %ld : ", event_id);)
+  TRACE(event_print_type(simulation_run->output, description);)
+  TRACE(fprintf(simulation_run->output, "Scheduled for  %.3f \n", SIM_TIME_TO_SECONDS(new_event_time));)
 
   /* Test for time scheduling error. */
   if (new_event_time < current_time) {
     printf("Error: Scheduling backwards in time: ");
-    printf("Event time = %f (Clock time = %f) \n", new_event_time, 
-    current_time);
-    printf("Event scheduled = \"%s\"\n", new_event.description);
+    printf("Event time = %f (Clock time = %f) \n",
+	   SIM_TIME_TO_SECONDS(new_event_time),
+	   SIM_TIME_TO_SECONDS(current_time));
+    printf("Event scheduled = \"%s\"\n", description);
     exit(1);
   }
 
-  new_container = (Event_Container_Ptr) xmalloc(sizeof(Event_Container));
-  new_container->occurrence_time = new_event_time;
-  new_container->event = new_event;
-  new_container->next_container = NULL;
-  new_container->previous_container = NULL;
-  new_container->event_id = event_id;
+  slot = eventlist_slot_new(event_list);
+  event_list->keys[slot].occurrence_time = new_event_time;
+  event_list->keys[slot].event_id = event_id;
 
-  if (event_list->size == 0) {
-    /* The list is empty. */
-    event_list->front_ptr = new_container;
-    event_list->back_ptr = new_container;
-    event_list->size++;
-    return event_id++;
+  payload = &event_list->payloads[slot];
+  payload->function = function;
+  payload->attachment = attachment;
+  payload->kind = kind;
+#ifdef TRACE_ON
+  payload->description = description;
+#endif
+
+  if (new_event_time == current_time)
+    eventlist_now_insert(event_list, slot);
+  else {
+    eventlist_insert(event_list, slot);
+    if (event_list->adaptive)
+      eventlist_adapt(event_list, slot, current_time,
+		      simulation_run->events_executed, simulation_run->output);
   }
 
-  if (event_list->front_ptr->occurrence_time > new_event_time) {
-    /* Add to front of the list. */
-    event_list->front_ptr->previous_container = new_container;
-    new_container->next_container = event_list->front_ptr;
-    event_list->front_ptr = new_container;
+  simulation_run->next_event_id = event_id + 1;
 
-    event_list->size++;
-    return event_id++;
+  handle.slot = slot;
+  handle.event_id = event_id;
+  return handle;
+}
+
+/*
+ * Given the handle of a scheduled event, remove the event from the event
+ * list. The event is unlinked directly, so this costs O(1) for the list,
+ * calendar queue and radix heap and O(log n) for the heap. The event
+ * attachment is returned (which could be NULL).
+ */
+
+void *
+simulation_run_deschedule_event(Simulation_Run_Ptr simulation_run,
+				Event_Handle handle)
+{
+  void * content_ptr;
+  int slot;
+
+  Eventlist_Ptr event_list;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+  slot = handle.slot;
+
+  if (slot < 0 || slot >= event_list->capacity ||
+      event_list->keys[slot].event_id != handle.event_id) {
+    printf("Error: Descheduling an event that is not scheduled.\n");
+    exit(1);
   }
 
-  if (event_list->back_ptr->occurrence_time <= new_event_time) {
-    /* Add to the back of the list. */
-    event_list->back_ptr->next_container = new_container;
-    new_container->previous_container = event_list->back_ptr;
-    event_list->back_ptr = new_container;
+  if (event_list->position[slot] == EVENT_SLOT_NOW)
+    eventlist_now_remove(event_list, slot);
+  else
+    eventlist_remove(event_list, slot);
+  content_ptr = event_list->payloads[slot].attachment;
 
-    event_list->size++;
-    return event_id++;
+  TRACE(fprintf(simulation_run->output, "At %.2f : ", simulation_run_get_time(simulation_run));)
+  TRACE(event_print_type(simulation_run->output, event_list->payloads[slot].description);)
+  TRACE(fprintf(simulation_run->output, "descheduled\n");)
+
+  eventlist_slot_free(event_list, slot);
+  return content_ptr;
+}
+
+/*
+ * Retrieve the event at the top of the event list, i.e., the next event to
+ * occur. This is called by execute_next_event which then passes execution to
+ * its event function.
+ */
+
+static int
+simulation_run_get_event(Simulation_Run_Ptr simulation_run)
+{
+  Eventlist_Ptr event_list;
+  int top_slot;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  if (event_list->now_size > 0) {
+    if (event_list->size == 0 ||
+	event_list->keys[eventlist_front(event_list)].occurrence_time >
+	simulation_run_get_sim_time(simulation_run)) {
+      top_slot = event_list->now_front;
+      eventlist_now_remove(event_list, top_slot);
+      return top_slot;
+    }
   }
 
-  /* Add to the middle of the list. */
-  current_container = event_list->front_ptr;
-  next_container = event_list->front_ptr->next_container;
+  if (event_list->size == 0) {
+    printf("*** Error: No Events are scheduled ... cannot continue! ***\n");
+    exit(1);
+  }
+
+  return eventlist_remove_front(event_list);
+}
+
+/*
+ * Get the next event from the event list and pass program execution to its
+ * event function.
+ */
+
+void
+simulation_run_execute_event(Simulation_Run_Ptr simulation_run)
+{
+  simulation_run_dispatch_event(simulation_run,
+				simulation_run_get_event(simulation_run));
+}
+
+/*
+ * Take the next event off the event list and dispatch it. A function event is
+ * executed here. For a kind event, its payload is stored through the payload
+ * pointer and its kind is returned, and the caller executes it. See the
+ * description of event kinds in simlib.h.
+ */
+
+int
+simulation_run_next_event(Simulation_Run_Ptr simulation_run,
+			  uint32_t * payload)
+{
+  Eventlist_Ptr event_list;
+  Event_Payload event_payload;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  if (event_list->size + event_list->now_size == 0)
+    return EVENT_KIND_NONE;
+
+  simulation_run_take_event(simulation_run,
+			    simulation_run_get_event(simulation_run),
+			    &event_payload);
+
+  if (event_payload.kind == EVENT_KIND_FUNCTION) {
+    (*(event_payload.function))(simulation_run, event_payload.attachment);
+    return EVENT_KIND_FUNCTION;
+  }
+
+  *payload = (uint32_t) (uintptr_t) event_payload.attachment;
+  return event_payload.kind;
+}
+
+/*
+ * Set the clock to the time of an event taken off the event list, count it,
+ * and copy out its payload. The slot is freed before the event is executed,
+ * so that events scheduled while executing it can reuse the slot.
+ */
+
+static void
+simulation_run_take_event(Simulation_Run_Ptr simulation_run, int slot,
+			  Event_Payload * payload)
+{
+  Eventlist_Ptr event_list;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  simulation_run_set_time(simulation_run,
+			  event_list->keys[slot].occurrence_time);
+  simulation_run->events_executed++;
+
+  *payload = event_list->payloads[slot];
+
+  TRACE(fprintf(simulation_run->output, "\n");)
+  TRACE(event_print_type(simulation_run->output, payload->description);)
+  TRACE(fprintf(simulation_run->output, "occurring at %.3f\n", simulation_run_get_time(simulation_run));)
+
+  eventlist_slot_free(event_list, slot);
+}
+
+/*
+ * Set the clock to the time of an event taken off the event list and call its
+ * event function.
+ */
+
+static void
+simulation_run_dispatch_event(Simulation_Run_Ptr simulation_run, int slot)
+{
+  Event_Payload payload;
+
+  simulation_run_take_event(simulation_run, slot, &payload);
+
+  if (payload.kind != EVENT_KIND_FUNCTION) {
+    printf("Error: Event kind %d must be taken with simulation_run_next_event.\n",
+	   payload.kind);
+    exit(1);
+  }
+
+  (*(payload.function))(simulation_run, payload.attachment);
+}
+
+/*
+ * Execute events until a stopping condition holds. The run stops when there
+ * are no more events, when the next event would occur after horizon_time (if
+ * horizon_time >= 0), when max_events events have been executed by this call
+ * (if max_events > 0), or when the predicate (if not NULL) returns nonzero.
+ * The reason for stopping is returned.
+ */
+
+Simulation_Run_Stop_Reason
+simulation_run_run_until(Simulation_Run_Ptr simulation_run,
+			 double horizon_time, long int max_events,
+			 Simulation_Run_Predicate predicate, void * ctx)
+{
+  Eventlist_Ptr event_list;
+  long int events_executed = 0;
+  int countdown = 0;
+
+  event_list = simulation_run_get_eventlist(simulation_run);
+
+  for (;;) {
+
+    if (predicate != NULL && --countdown <= 0) {
+      if ((*predicate)(simulation_run, ctx))
+	return SIMULATION_RUN_STOP_PREDICATE;
+      countdown = simulation_run->predicate_interval;
+    }
+
+    if (max_events > 0 && events_executed >= max_events)
+      return SIMULATION_RUN_STOP_MAX_EVENTS;
+
+    if (event_list->size + event_list->now_size == 0)
+      return SIMULATION_RUN_STOP_NO_EVENTS;
+
+    /* Events on the now queue are at the current time. */
+    if (horizon_time >= 0.0 && event_list->now_size == 0 &&
+	event_list->keys[eventlist_front(event_list)].occurrence_time >
+	SIM_TIME_FROM_SECONDS(horizon_time))
+      return SIMULATION_RUN_STOP_HORIZON;
+
+    simulation_run_dispatch_event(simulation_run,
+				  simulation_run_get_event(simulation_run));
+    events_executed++;
+  }
+}
+
+/*
+ * Set how many events simulation_run_run_until executes between checks of its
+ * predicate.
+ */
+
+void
+simulation_run_set_predicate_interval(Simulation_Run_Ptr simulation_run,
+				      int interval)
+{
+  if (interval < 1) {
+    printf("Error: The predicate interval must be at least 1.\n");
+    exit(1);
+  }
+  simulation_run->predicate_interval = interval;
+}
+
+/*
+ * Get the total number of events executed so far by the simulation_run.
+ */
+
+long int
+simulation_run_events_executed(Simulation_Run_Ptr simulation_run)
+{
+  return simulation_run->events_executed;
+}
+
+/*
+ * Report the fraction of event slots that were taken from the free list rather
+ * than by growing the event storage.
+ */
+
+double
+simulation_run_event_pool_hit_rate(Simulation_Run_Ptr simulation_run)
+{
+  Eventlist_Ptr event_list = simulation_run_get_eventlist(simulation_run);
+
+  if (event_list->requests == 0)
+    return 0.0;
+  return (double) event_list->hits / event_list->requests;
+}
+
+/*
+ * Get the arena of a simulation_run. Model objects that only live as long as
+ * the simulation_run can be allocated from it, and are then freed along with
+ * it.
+ */
+
+Arena_Ptr
+simulation_run_arena(Simulation_Run_Ptr simulation_run)
+{
+  return simulation_run->arena;
+}
+
+/*
+ * Free up simulation_run memory. The simulation_run, its event storage (with
+ * any events still on the event list) and anything else allocated from its
+ * arena are released together.
+ */
+
+void
+simulation_run_free_memory(Simulation_Run_Ptr this_simulation_run)
+{
+  /* Clean up the simulation_run. */
+  arena_release(this_simulation_run->arena);
+}
+
+/*
+ * Functions for handling various event list operations.
+ *
+ * Create a new event list. This is called when a simulation_run is
+ * created. The event list is included in the simulation_run. Storage for
+ * EVENT_POOL_INITIAL_SIZE events is allocated up front, as are the calendar
+ * buckets, so that any of the structures can be selected without extra work.
+ */
+
+static Eventlist_Ptr
+eventlist_new(Arena_Ptr arena)
+{
+  Eventlist_Ptr new_event_list;
+
+  new_event_list = (Eventlist_Ptr) arena_alloc(arena, sizeof(Eventlist));
+
+  new_event_list->arena = arena;
+  new_event_list->configured_type = EVENTLIST_HEAP;
+  new_event_list->adaptive = 0;
+
+  new_event_list->keys = NULL;
+  new_event_list->payloads = NULL;
+  new_event_list->next = NULL;
+  new_event_list->previous = NULL;
+  new_event_list->position = NULL;
+  new_event_list->heap = NULL;
+  new_event_list->scratch = NULL;
+  new_event_list->scratch_capacity = 0;
+  new_event_list->capacity = 0;
+  new_event_list->free_slot = NO_SLOT;
+  eventlist_grow(new_event_list, EVENT_POOL_INITIAL_SIZE);
+
+  new_event_list->calendar = (int *)
+    arena_alloc(arena, CALENDAR_MIN_BUCKETS * sizeof(int));
+  new_event_list->calendar_capacity = CALENDAR_MIN_BUCKETS;
+
+  new_event_list->switches = NULL;
+  new_event_list->switch_capacity = 0;
+
+  eventlist_reset(new_event_list);
+  return new_event_list;
+}
+
+/*
+ * Empty the event list and return it to the state it had when it was
+ * created, but keep its storage. Every slot is put back on the free list. The
+ * configured structure type and the adaptive setting are kept, and any
+ * structure chosen by adaptive selection is dropped.
+ */
+
+static void
+eventlist_reset(Eventlist_Ptr event_list)
+{
+  int i, slot;
+
+  event_list->type = event_list->configured_type;
+
+  event_list->free_slot = NO_SLOT;
+  for (slot=event_list->capacity-1; slot>=0; slot--) {
+    event_list->keys[slot].event_id = 0;
+    event_list->position[slot] = EVENT_SLOT_FREE;
+    event_list->next[slot] = event_list->free_slot;
+    event_list->free_slot = slot;
+  }
+  event_list->requests = 0;
+  event_list->hits = 0;
+
+  event_list->front = NO_SLOT;
+  event_list->back = NO_SLOT;
+
+  for (i=0; i<CALENDAR_MIN_BUCKETS; i++)
+    event_list->calendar[i] = NO_SLOT;
+  event_list->calendar_buckets = CALENDAR_MIN_BUCKETS;
+  event_list->calendar_width =
+    (double) SIM_TIME_FROM_SECONDS(CALENDAR_INITIAL_WIDTH);
+  event_list->calendar_current = 0;
+  event_list->calendar_last_time = 0;
+  event_list->calendar_mean_gap = 0.0;
+  event_list->calendar_dequeues = 0;
+
+  for (i=0; i<RADIX_BUCKETS; i++) {
+    event_list->radix_head[i] = NO_SLOT;
+    event_list->radix_tail[i] = NO_SLOT;
+  }
+  event_list->radix_last = 0;
+  event_list->radix_min = NO_SLOT;
+
+  event_list->adaptive_inserts = 0;
+  event_list->adaptive_back_inserts = 0;
+  event_list->adaptive_scan = 0;
+  event_list->adaptive_back_time = 0;
+  event_list->switch_count = 0;
+
+  event_list->now_front = NO_SLOT;
+  event_list->now_back = NO_SLOT;
+  event_list->now_size = 0;
+  event_list->size = 0;
+}
+
+/*
+ * Get a pointer to the eventlist. This is intended for use only by simlib.
+ */
+
+static Eventlist_Ptr
+simulation_run_get_eventlist(Simulation_Run_Ptr simulation_run)
+{
+  return simulation_run->eventlist;
+}
+
+/*
+ * Event storage functions.
+ *
+ * Grow the per-slot arrays to a new capacity and put the new slots on the free
+ * list. The heap can never hold more than every slot, so it grows with them.
+ */
+
+static void
+eventlist_grow(Eventlist_Ptr event_list, int capacity)
+{
+  Arena_Ptr arena = event_list->arena;
+  int old_capacity = event_list->capacity;
+  int slot;
+
+  event_list->keys = (Event_Key *)
+    arena_realloc(arena, event_list->keys, old_capacity * sizeof(Event_Key),
+		  capacity * sizeof(Event_Key));
+  event_list->payloads = (Event_Payload *)
+    arena_realloc(arena, event_list->payloads,
+		  old_capacity * sizeof(Event_Payload),
+		  capacity * sizeof(Event_Payload));
+  event_list->next = (int *)
+    arena_realloc(arena, event_list->next, old_capacity * sizeof(int),
+		  capacity * sizeof(int));
+  event_list->previous = (int *)
+    arena_realloc(arena, event_list->previous, old_capacity * sizeof(int),
+		  capacity * sizeof(int));
+  event_list->position = (int *)
+    arena_realloc(arena, event_list->position, old_capacity * sizeof(int),
+		  capacity * sizeof(int));
+  event_list->heap = (Event_Heap_Entry *)
+    arena_realloc(arena, event_list->heap,
+		  old_capacity * sizeof(Event_Heap_Entry),
+		  capacity * sizeof(Event_Heap_Entry));
+
+  for (slot=capacity-1; slot>=event_list->capacity; slot--) {
+    event_list->keys[slot].event_id = 0;
+    event_list->position[slot] = EVENT_SLOT_FREE;
+    event_list->next[slot] = event_list->free_slot;
+    event_list->free_slot = slot;
+  }
+  event_list->capacity = capacity;
+}
+
+/*
+ * Take a slot from the free list, doubling the storage if the free list is
+ * empty.
+ */
+
+static int
+eventlist_slot_new(Eventlist_Ptr event_list)
+{
+  int slot;
+
+  event_list->requests++;
+  if (event_list->free_slot == NO_SLOT)
+    eventlist_grow(event_list, 2 * event_list->capacity);
+  else
+    event_list->hits++;
+
+  slot = event_list->free_slot;
+  event_list->free_slot = event_list->next[slot];
+  return slot;
+}
+
+/*
+ * Return a slot to the free list. Its event_id is cleared so that a stale
+ * handle to it can be recognized.
+ */
+
+static void
+eventlist_slot_free(Eventlist_Ptr event_list, int slot)
+{
+  event_list->keys[slot].event_id = 0;
+  event_list->position[slot] = EVENT_SLOT_FREE;
+  event_list->next[slot] = event_list->free_slot;
+  event_list->free_slot = slot;
+}
+
+/*
+ * Event ordering. An event precedes another if it occurs earlier, or if it
+ * occurs at the same time but was scheduled first. The event_id is assigned in
+ * increasing order so it serves as the scheduling sequence number.
+ */
+
+static int
+event_precedes(Eventlist_Ptr event_list, int first, int second)
+{
+  return event_key_precedes(&event_list->keys[first],
+			    &event_list->keys[second]);
+}
+
+/*
+ * Event list operations. These pass the request on to the structure that is
+ * selected by the event list type.
+ */
+
+static void
+eventlist_insert(Eventlist_Ptr event_list, int slot)
+{
+  switch (event_list->type) {
+  case EVENTLIST_HEAP:
+    eventlist_heap_insert(event_list, slot);
+    break;
+  case EVENTLIST_CALENDAR:
+    eventlist_calendar_insert(event_list, slot);
+    break;
+  case EVENTLIST_RADIX:
+    eventlist_radix_insert(event_list, slot);
+    break;
+  default:
+    eventlist_list_insert(event_list, slot);
+    break;
+  }
+}
+
+static void
+eventlist_remove(Eventlist_Ptr event_list, int slot)
+{
+  switch (event_list->type) {
+  case EVENTLIST_HEAP:
+    eventlist_heap_remove(event_list, event_list->position[slot]);
+    break;
+  case EVENTLIST_CALENDAR:
+    eventlist_calendar_remove(event_list, slot);
+    break;
+  case EVENTLIST_RADIX:
+    eventlist_radix_remove(event_list, slot);
+    break;
+  default:
+    eventlist_list_remove(event_list, slot);
+    break;
+  }
+}
+
+static int
+eventlist_remove_front(Eventlist_Ptr event_list)
+{
+  int top_slot;
+
+  switch (event_list->type) {
+  case EVENTLIST_HEAP:
+    top_slot = event_list->heap[0].slot;
+    eventlist_heap_remove(event_list, 0);
+    break;
+  case EVENTLIST_CALENDAR:
+    top_slot = eventlist_calendar_remove_front(event_list);
+    break;
+  case EVENTLIST_RADIX:
+    top_slot = eventlist_radix_remove_front(event_list);
+    break;
+  default:
+    top_slot = event_list->front;
+    eventlist_list_remove(event_list, top_slot);
+    break;
+  }
+  return top_slot;
+}
+
+/*
+ * Look at the next event without removing it.
+ */
+
+static int
+eventlist_front(Eventlist_Ptr event_list)
+{
+  switch (event_list->type) {
+  case EVENTLIST_HEAP:
+    return event_list->heap[0].slot;
+  case EVENTLIST_CALENDAR:
+    return eventlist_calendar_front(event_list);
+  case EVENTLIST_RADIX:
+    return eventlist_radix_front(event_list);
+  default:
+    return event_list->front;
+  }
+}
+
+/*
+ * The "now" queue. Events scheduled for the current clock time are appended
+ * to a plain FIFO instead of being put into the sorted structure. Any events
+ * in the sorted structure for the current time were scheduled earlier, so
+ * they are served first, and the now queue is always empty before the clock
+ * moves on. This gives the same order as putting them in the sorted
+ * structure.
+ */
+
+static void
+eventlist_now_insert(Eventlist_Ptr event_list, int slot)
+{
+  event_list->position[slot] = EVENT_SLOT_NOW;
+  event_list->next[slot] = NO_SLOT;
+  event_list->previous[slot] = event_list->now_back;
+
+  if (event_list->now_size == 0)
+    event_list->now_front = slot;
+  else
+    event_list->next[event_list->now_back] = slot;
+
+  event_list->now_back = slot;
+  event_list->now_size++;
+}
+
+static void
+eventlist_now_remove(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+
+  if (previous[slot] != NO_SLOT)
+    next[previous[slot]] = next[slot];
+  else
+    event_list->now_front = next[slot];
+
+  if (next[slot] != NO_SLOT)
+    previous[next[slot]] = previous[slot];
+  else
+    event_list->now_back = previous[slot];
+
+  event_list->now_size--;
+}
+
+/*
+ * Sorted list insertion. The event list is a double linked list. A new event
+ * is placed after any events that precede it.
+ */
+
+static void
+eventlist_list_insert(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+  int current_slot, next_slot;
+
+  event_list->position[slot] = EVENT_SLOT_LISTED;
+
+  if (event_list->size == 0) {
+    /* The list is empty. */
+    next[slot] = NO_SLOT;
+    previous[slot] = NO_SLOT;
+    event_list->front = slot;
+    event_list->back = slot;
+    event_list->size++;
+    return;
+  }
+
+  if (event_precedes(event_list, slot, event_list->front)) {
+    /* Add to front of the list. */
+    previous[event_list->front] = slot;
+    next[slot] = event_list->front;
+    previous[slot] = NO_SLOT;
+    event_list->front = slot;
+
+    event_list->size++;
+    return;
+  }
+
+  if (event_precedes(event_list, event_list->back, slot)) {
+    /* Add to the back of the list. */
+    next[event_list->back] = slot;
+    previous[slot] = event_list->back;
+    next[slot] = NO_SLOT;
+    event_list->back = slot;
+
+    event_list->size++;
+    return;
+  }
+
+  /* Add to the middle of the list. */
+  current_slot = event_list->front;
+  next_slot = next[current_slot];
+
+  while(event_precedes(event_list, next_slot, slot)) {
+    current_slot = next_slot;
+    next_slot = next[current_slot];
+    event_list->adaptive_scan++;
+  }
+  next[current_slot] = slot;
+  previous[slot] = current_slot;
+  previous[next_slot] = slot;
+  next[slot] = next_slot;
+
+  event_list->size++;
+}
+
+/*
+ * Unlink an event from anywhere in the list.
+ */
+
+static void
+eventlist_list_remove(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+
+  /* Front of list. Adjust the front pointer. */
+  if (event_list->front == slot)
+    event_list->front = next[slot];
+
+  /* Back of list. Adjust the back pointer (could be both front and back). */
+  if (event_list->back == slot)
+    event_list->back = previous[slot];
+
+  /* If the next event exists, adjust its previous event pointer. */
+  if (next[slot] != NO_SLOT)
+    previous[next[slot]] = previous[slot];
+
+  /* If the previous event exists, adjust its next event pointer. */
+  if (previous[slot] != NO_SLOT)
+    next[previous[slot]] = next[slot];
+
+  event_list->size--;
+}
+
+/*
+ * Heap operations. The heap is an array of Event_Heap_Entries, each holding a
+ * copy of an event's key along with its slot, so that ordering the heap only
+ * touches the heap array itself. The children of entry i are at entries
+ * EVENTLIST_HEAP_ARITY*i+1 onward. The heap index of each slot is kept in the
+ * position array so that an event can be removed from the middle of the heap.
+ */
+
+static int
+event_key_precedes(Event_Key * first, Event_Key * second)
+{
+  if (first->occurrence_time != second->occurrence_time)
+    return first->occurrence_time < second->occurrence_time;
+  return first->event_id < second->event_id;
+}
+
+static void
+eventlist_heap_sift_up(Eventlist_Ptr event_list, int index)
+{
+  Event_Heap_Entry * heap = event_list->heap;
+  Event_Heap_Entry entry = heap[index];
+  int parent;
+
+  while (index > 0) {
+    parent = (index - 1) / EVENTLIST_HEAP_ARITY;
+    if (!event_key_precedes(&entry.key, &heap[parent].key))
+      break;
+    heap[index] = heap[parent];
+    event_list->position[heap[index].slot] = index;
+    index = parent;
+  }
+  heap[index] = entry;
+  event_list->position[entry.slot] = index;
+}
+
+static void
+eventlist_heap_sift_down(Eventlist_Ptr event_list, int index)
+{
+  Event_Heap_Entry * heap = event_list->heap;
+  Event_Heap_Entry entry = heap[index];
+  int child, first_child, last_child, best_child;
+
+  for (;;) {
+    first_child = EVENTLIST_HEAP_ARITY * index + 1;
+    if (first_child >= event_list->size)
+      break;
+
+    last_child = first_child + EVENTLIST_HEAP_ARITY;
+    if (last_child > event_list->size)
+      last_child = event_list->size;
+
+    best_child = first_child;
+    for (child = first_child + 1; child < last_child; child++)
+      if (event_key_precedes(&heap[child].key, &heap[best_child].key))
+	best_child = child;
+
+    if (!event_key_precedes(&heap[best_child].key, &entry.key))
+      break;
+    heap[index] = heap[best_child];
+    event_list->position[heap[index].slot] = index;
+    index = best_child;
+  }
+  heap[index] = entry;
+  event_list->position[entry.slot] = index;
+}
+
+static void
+eventlist_heap_insert(Eventlist_Ptr event_list, int slot)
+{
+  event_list->heap[event_list->size].key = event_list->keys[slot];
+  event_list->heap[event_list->size].slot = slot;
+  event_list->size++;
+  eventlist_heap_sift_up(event_list, event_list->size - 1);
+}
+
+/*
+ * Remove the entry at a given heap position. The last entry is moved into the
+ * hole and then sifted up or down as needed.
+ */
+
+static void
+eventlist_heap_remove(Eventlist_Ptr event_list, int index)
+{
+  Event_Heap_Entry * heap = event_list->heap;
+
+  event_list->size--;
+  if (index == event_list->size)
+    return;
+
+  heap[index] = heap[event_list->size];
+  event_list->position[heap[index].slot] = index;
+
+  if (index > 0 &&
+      event_key_precedes(&heap[index].key,
+			 &heap[(index - 1) / EVENTLIST_HEAP_ARITY].key))
+    eventlist_heap_sift_up(event_list, index);
+  else
+    eventlist_heap_sift_down(event_list, index);
+}
+
+/*
+ * Calendar queue operations. Time is divided into days of calendar_width
+ * Sim_Time units, and day d is kept in bucket d modulo calendar_buckets (a
+ * power of two). Each bucket is a sorted double linked list. calendar_current
+ * is the day of the last event removed, and no pending event can be earlier
+ * than that since events are never scheduled in the past.
+ */
+
+static long long
+eventlist_calendar_day(Eventlist_Ptr event_list, Sim_Time time)
+{
+  return (long long) ((double) time / event_list->calendar_width);
+}
+
+static void
+eventlist_calendar_insert(Eventlist_Ptr event_list, int slot)
+{
+  eventlist_calendar_place(event_list, slot);
+
+  event_list->size++;
+  if (event_list->size > 2 * event_list->calendar_buckets)
+    eventlist_calendar_resize(event_list, 2 * event_list->calendar_buckets);
+}
+
+/*
+ * Place an event in its bucket, after any events in that bucket that precede
+ * it.
+ */
+
+static void
+eventlist_calendar_place(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+  int * bucket;
+  int current_slot;
+
+  event_list->position[slot] = EVENT_SLOT_LISTED;
+  bucket = &event_list->calendar[eventlist_calendar_day(event_list,
+			 event_list->keys[slot].occurrence_time)
+				 & (event_list->calendar_buckets - 1)];
+
+  if (*bucket == NO_SLOT || event_precedes(event_list, slot, *bucket)) {
+    /* Add to the front of the bucket. */
+    previous[slot] = NO_SLOT;
+    next[slot] = *bucket;
+    if (*bucket != NO_SLOT)
+      previous[*bucket] = slot;
+    *bucket = slot;
+  } else {
+    current_slot = *bucket;
+    while (next[current_slot] != NO_SLOT &&
+	   !event_precedes(event_list, slot, next[current_slot]))
+      current_slot = next[current_slot];
+
+    previous[slot] = current_slot;
+    next[slot] = next[current_slot];
+    if (next[current_slot] != NO_SLOT)
+      previous[next[current_slot]] = slot;
+    next[current_slot] = slot;
+  }
+}
+
+static void
+eventlist_calendar_remove(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+  int buckets;
+
+  if (previous[slot] != NO_SLOT)
+    next[previous[slot]] = next[slot];
+  else
+    event_list->calendar[eventlist_calendar_day(event_list,
+		  event_list->keys[slot].occurrence_time)
+			 & (event_list->calendar_buckets - 1)] = next[slot];
+
+  if (next[slot] != NO_SLOT)
+    previous[next[slot]] = previous[slot];
 
-  while(next_container->occurrence_time <= new_event_time) {
-    current_container = next_container;
-    next_container = current_container->next_container;
-  }
-  current_container->next_container = new_container;
-  new_container->previous_container = current_container;
-  next_container->previous_container = new_container;
-  new_container->next_container = next_container;
+  event_list->size--;
 
-  event_list->size++;
-  return event_id++;
+  buckets = event_list->calendar_buckets;
+  if (buckets > CALENDAR_MIN_BUCKETS && event_list->size < buckets / 2)
+    eventlist_calendar_resize(event_list, buckets / 2);
 }
 
 /*
- * Given an existing event id, remove the corresponding event from the event
- * list. The event content pointer is returned (which could be NULL). If the
- * requested event does not exist, it will return a NULL pointer.
+ * Find the next event. Starting at the current day, look for a bucket whose
+ * first event falls on the day being examined. If a whole year of buckets is
+ * empty, find the earliest event directly.
  */
 
-void *
-simulation_run_deschedule_event(Simulation_Run_Ptr simulation_run,
-				long int event_id)
+static int
+eventlist_calendar_front(Eventlist_Ptr event_list)
 {
-  int i;
-  Event_Container_Ptr current_container, found_container=NULL,
-    next_container, previous_container;
-  void * content_ptr = NULL;
-
-  Eventlist_Ptr event_list;
-
-  event_list = simulation_run_get_eventlist(simulation_run);
+  int top_slot = NO_SLOT;
+  int slot;
+  int i, mask;
+  long long day;
+
+  mask = event_list->calendar_buckets - 1;
+
+  for (i=0; i<event_list->calendar_buckets; i++) {
+    day = event_list->calendar_current + i;
+    slot = event_list->calendar[day & mask];
+    if (slot != NO_SLOT &&
+	eventlist_calendar_day(event_list,
+			       event_list->keys[slot].occurrence_time) == day)
+      return slot;
+  }
 
-  current_container = event_list->front_ptr;
-  next_container = current_container->next_container;
+  for (i=0; i<event_list->calendar_buckets; i++) {
+    slot = event_list->calendar[i];
+    if (slot != NO_SLOT && (top_slot == NO_SLOT ||
+			    event_precedes(event_list, slot, top_slot)))
+      top_slot = slot;
+  }
+  return top_slot;
+}
 
-  for(i=0; i<event_list->size; i++) {
+/*
+ * Remove the next event and move the current day ahead to its day. The running
+ * mean of the gaps between removed events is used to recalibrate the bucket
+ * width every CALENDAR_RECALIBRATE_INTERVAL removals.
+ */
 
-    if(current_container->event_id == event_id) {
+static int
+eventlist_calendar_remove_front(Eventlist_Ptr event_list)
+{
+  int top_slot;
+  Sim_Time time;
+  double gap, width;
 
-      found_container = current_container;
-      previous_container = found_container->previous_container;
-      next_container = found_container->next_container;
+  top_slot = eventlist_calendar_front(event_list);
+  time = event_list->keys[top_slot].occurrence_time;
 
-      /* Front of list. Adjust the front pointer. */
-      if (event_list->front_ptr == found_container)
-        event_list->front_ptr = next_container;
+  event_list->calendar_current = eventlist_calendar_day(event_list, time);
 
-      /* Back of list. Adjust the back pointer (could be both fron and
-	 back). */
-      if (event_list->back_ptr == found_container)
-        event_list->back_ptr = previous_container;
+  gap = (double) (time - event_list->calendar_last_time);
+  event_list->calendar_mean_gap +=
+    (gap - event_list->calendar_mean_gap) / CALENDAR_GAP_WEIGHT;
+  event_list->calendar_last_time = time;
 
-      /* If the next event exists, adjust its previous event pointer. */
-      if (next_container != NULL)
-        next_container->previous_container = previous_container;
+  eventlist_calendar_remove(event_list, top_slot);
 
-      /* If the previous event exists, adjust its next event pointer. */
-      if (previous_container != NULL)
-        previous_container->next_container = next_container;
+  if (++event_list->calendar_dequeues % CALENDAR_RECALIBRATE_INTERVAL == 0) {
+    width = 3.0 * event_list->calendar_mean_gap;
+    if (width > 0.0 && (width > 2.0 * event_list->calendar_width ||
+			width < 0.5 * event_list->calendar_width))
+      eventlist_calendar_resize(event_list, event_list->calendar_buckets);
+  }
+  return top_slot;
+}
 
-      content_ptr = found_container->data_ptr;
+/*
+ * Rebuild the calendar with a new number of buckets. The bucket width is set
+ * to three times the mean observed gap between events (as suggested by Brown)
+ * once such a gap has been seen, otherwise the current width is kept. The
+ * events are first chained together through next so that the bucket array
+ * can be rebuilt in place. It is only reallocated if it has to grow beyond
+ * its largest size so far.
+ */
 
-      TRACE(printf("At %.2f : ", simulation_run_get_time(simulation_run));)
-      TRACE(event_print_type(found_container->event);)
-      TRACE(printf("descheduled\n");)
+static void
+eventlist_calendar_resize(Eventlist_Ptr event_list, int buckets)
+{
+  int chain = NO_SLOT;
+  int slot, next_slot;
+  int i;
 
-      free((void*) found_container);
-      event_list->size--;
-      break;
+  for (i=0; i<event_list->calendar_buckets; i++) {
+    slot = event_list->calendar[i];
+    while (slot != NO_SLOT) {
+      next_slot = event_list->next[slot];
+      event_list->next[slot] = chain;
+      chain = slot;
+      slot = next_slot;
     }
-    current_container = current_container->next_container;
+  }
 
+  eventlist_calendar_reserve(event_list, buckets);
+  for (i=0; i<buckets; i++)
+    event_list->calendar[i] = NO_SLOT;
+  event_list->calendar_buckets = buckets;
+  if (event_list->calendar_mean_gap > 0.0)
+    event_list->calendar_width = 3.0 * event_list->calendar_mean_gap;
+  event_list->calendar_current =
+    eventlist_calendar_day(event_list, event_list->calendar_last_time);
+
+  for (slot = chain; slot != NO_SLOT; slot = next_slot) {
+    next_slot = event_list->next[slot];
+    eventlist_calendar_place(event_list, slot);
   }
-  return content_ptr;
 }
 
 /*
- * Retrieve the event at the top of the event list, i.e., the next event to
- * occur. This is called by execute_next_event which then passes execution to
- * its event function.
+ * Make sure that the calendar array can hold a number of buckets.
  */
 
-static Event_Container_Ptr
-simulation_run_get_event(Simulation_Run_Ptr simulation_run)
+static void
+eventlist_calendar_reserve(Eventlist_Ptr event_list, int buckets)
 {
-  Eventlist_Ptr event_list;
-  Event_Container_Ptr top_container;
+  if (buckets <= event_list->calendar_capacity)
+    return;
+
+  event_list->calendar = (int *)
+    arena_realloc(event_list->arena, event_list->calendar,
+		  event_list->calendar_capacity * sizeof(int),
+		  buckets * sizeof(int));
+  event_list->calendar_capacity = buckets;
+}
 
-  event_list = simulation_run_get_eventlist(simulation_run);
+/*
+ * Radix heap operations. Keys are compared as unsigned 64 bit integers. In
+ * the default mode the occurrence time is a non-negative double, and the bit
+ * pattern of such a double orders the same way as its value (-0.0 is mapped
+ * to 0 so that it sorts with 0.0).
+ */
 
-  if (event_list->size == 0) {
-    printf("*** Error: No Events are scheduled ... cannot continue! ***\n");
-    exit(1);
+static uint64_t
+eventlist_radix_key(Sim_Time time)
+{
+#ifdef SIMLIB_TICK_CLOCK
+  return time;
+#else
+  uint64_t key;
+
+  if (time == 0.0)
+    return 0;
+  memcpy(&key, &time, sizeof(key));
+  return key;
+#endif
+}
+
+/*
+ * The bucket for a key is one more than the highest bit in which it differs
+ * from the last removed key, or 0 if it is equal to it.
+ */
+
+static int
+eventlist_radix_bucket(Eventlist_Ptr event_list, uint64_t key)
+{
+  uint64_t difference = key ^ event_list->radix_last;
+  int bucket = 0;
+
+  if (difference == 0)
+    return 0;
+#ifdef __GNUC__
+  bucket = 64 - __builtin_clzll(difference);
+#else
+  while (difference != 0) {
+    difference >>= 1;
+    bucket++;
   }
+#endif
+  return bucket;
+}
+
+static void
+eventlist_radix_insert(Eventlist_Ptr event_list, int slot)
+{
+  eventlist_radix_place(event_list, slot);
 
-  top_container = event_list->front_ptr;
+  if (event_list->radix_min != NO_SLOT &&
+      event_precedes(event_list, slot, event_list->radix_min))
+    event_list->radix_min = slot;
+  event_list->size++;
+}
 
-  if (event_list->size == 1) {
-    event_list->front_ptr = NULL;
-    event_list->back_ptr = NULL;
-    event_list->size--;
-  } else {
+/*
+ * Put an event in its bucket. Buckets are appended to, except bucket 0 where
+ * the event is placed after any events with a smaller event_id. New events
+ * always have the largest event_id, so this only has to search when events
+ * are moved down from a higher bucket.
+ */
 
-    top_container->next_container->previous_container = NULL;
-    event_list->front_ptr = top_container->next_container;
-    event_list->size--;
+static void
+eventlist_radix_place(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+  int bucket, current_slot;
+
+  bucket = eventlist_radix_bucket(event_list,
+	   eventlist_radix_key(event_list->keys[slot].occurrence_time));
+  event_list->position[slot] = bucket;
+
+  current_slot = event_list->radix_tail[bucket];
+  if (bucket == 0)
+    while (current_slot != NO_SLOT &&
+	   event_list->keys[slot].event_id <
+	   event_list->keys[current_slot].event_id)
+      current_slot = previous[current_slot];
+
+  /* Link the event in after current_slot. */
+  previous[slot] = current_slot;
+  if (current_slot == NO_SLOT) {
+    next[slot] = event_list->radix_head[bucket];
+    event_list->radix_head[bucket] = slot;
+  } else {
+    next[slot] = next[current_slot];
+    next[current_slot] = slot;
   }
-  return (top_container);
+  if (next[slot] == NO_SLOT)
+    event_list->radix_tail[bucket] = slot;
+  else
+    previous[next[slot]] = slot;
+}
+
+static void
+eventlist_radix_remove(Eventlist_Ptr event_list, int slot)
+{
+  int * next = event_list->next;
+  int * previous = event_list->previous;
+  int bucket = event_list->position[slot];
+
+  if (previous[slot] != NO_SLOT)
+    next[previous[slot]] = next[slot];
+  else
+    event_list->radix_head[bucket] = next[slot];
+
+  if (next[slot] != NO_SLOT)
+    previous[next[slot]] = previous[slot];
+  else
+    event_list->radix_tail[bucket] = previous[slot];
+
+  if (event_list->radix_min == slot)
+    event_list->radix_min = NO_SLOT;
+  event_list->size--;
 }
 
 /*
- * Get the next event from the event list and pass program execution to its
- * event function.
+ * Find the next event. This is the first event in bucket 0 if there is one.
+ * Otherwise it is the earliest event in the lowest non-empty bucket, which is
+ * remembered in radix_min until the radix heap changes. The buckets are not
+ * redistributed here, since a later event could still be scheduled before the
+ * event that is found.
  */
 
-void
-simulation_run_execute_event(Simulation_Run_Ptr simulation_run)
+static int
+eventlist_radix_front(Eventlist_Ptr event_list)
 {
-  Event_Container_Ptr current_container;
+  int bucket, slot;
+
+  if (event_list->radix_head[0] != NO_SLOT)
+    return event_list->radix_head[0];
+
+  if (event_list->radix_min == NO_SLOT) {
+    for (bucket=1; event_list->radix_head[bucket] == NO_SLOT; bucket++)
+      ;
+    slot = event_list->radix_head[bucket];
+    event_list->radix_min = slot;
+    for (slot = event_list->next[slot]; slot != NO_SLOT;
+	 slot = event_list->next[slot])
+      if (event_precedes(event_list, slot, event_list->radix_min))
+	event_list->radix_min = slot;
+  }
+  return event_list->radix_min;
+}
 
-  current_container = simulation_run_get_event(simulation_run);
-  simulation_run_set_time(simulation_run, 
-			  current_container->occurrence_time);
+/*
+ * Remove the next event. If bucket 0 is empty, the last removed key moves up
+ * to the smallest key in the lowest non-empty bucket and the events in that
+ * bucket are placed again. They all land in lower buckets, and at least one of
+ * them in bucket 0.
+ */
 
-  TRACE(printf("\n");)
-  TRACE(event_print_type(current_container->event);)
-  TRACE(printf("occurring at %.3f\n", simulation_run_get_time(simulation_run));)
+static int
+eventlist_radix_remove_front(Eventlist_Ptr event_list)
+{
+  int bucket, slot, next_slot;
+
+  if (event_list->radix_head[0] == NO_SLOT) {
+    slot = eventlist_radix_front(event_list);
+    bucket = event_list->position[slot];
+    event_list->radix_last =
+      eventlist_radix_key(event_list->keys[slot].occurrence_time);
+
+    slot = event_list->radix_head[bucket];
+    event_list->radix_head[bucket] = NO_SLOT;
+    event_list->radix_tail[bucket] = NO_SLOT;
+    while (slot != NO_SLOT) {
+      next_slot = event_list->next[slot];
+      eventlist_radix_place(event_list, slot);
+      slot = next_slot;
+    }
+  }
 
-  (*(current_container->event.function))(simulation_run,
-			current_container->event.attachment);
-  xfree(current_container);
+  slot = event_list->radix_head[0];
+  eventlist_radix_remove(event_list, slot);
+  event_list->radix_min = NO_SLOT;
+  return slot;
 }
 
 /*
- * Free up simulation_run memory.
+ * Adaptive selection. Record where a newly inserted event fell and, at the
+ * end of each window, move to the structure that the window suggests. An
+ * event goes to the back if it is not earlier than any event inserted since
+ * the structure was last empty. Switches are traced to output.
  */
 
-void
-simulation_run_free_memory(Simulation_Run_Ptr this_simulation_run)
+static void
+eventlist_adapt(Eventlist_Ptr event_list, int slot, Sim_Time now,
+		long int events_executed, FILE * output)
 {
-  Eventlist_Ptr event_list;
+  Eventlist_Switch * log_entry;
+  Eventlist_Type type;
+  Sim_Time time;
+
+  (void) output;    /* Only used when tracing. */
+  time = event_list->keys[slot].occurrence_time;
+  if (event_list->size == 1 || time >= event_list->adaptive_back_time) {
+    event_list->adaptive_back_time = time;
+    event_list->adaptive_back_inserts++;
+  }
+
+  if (++event_list->adaptive_inserts < ADAPTIVE_WINDOW)
+    return;
+
+  type = eventlist_adaptive_choice(event_list);
+  event_list->adaptive_inserts = 0;
+  event_list->adaptive_back_inserts = 0;
+  event_list->adaptive_scan = 0;
+  if (type == event_list->type)
+    return;
+
+  if (event_list->switch_count == event_list->switch_capacity) {
+    event_list->switch_capacity = event_list->switch_capacity == 0 ?
+      8 : 2 * event_list->switch_capacity;
+    event_list->switches = (Eventlist_Switch *)
+      arena_realloc(event_list->arena, event_list->switches,
+		    event_list->switch_count * sizeof(Eventlist_Switch),
+		    event_list->switch_capacity * sizeof(Eventlist_Switch));
+  }
+  log_entry = &event_list->switches[event_list->switch_count++];
+  log_entry->time = now;
+  log_entry->events_executed = events_executed;
+  log_entry->from = event_list->type;
+  log_entry->to = type;
+  log_entry->size = event_list->size;
+
+  TRACE(fprintf(output, "At %.3f : event list switched from %s to %s (%d events)\n",
+		SIM_TIME_TO_SECONDS(now), eventlist_type_name(log_entry->from),
+		eventlist_type_name(type), event_list->size);)
+
+  eventlist_migrate(event_list, type, now);
+}
 
-  /* Clean out the event list. */
-  event_list = this_simulation_run->eventlist;
+static Eventlist_Type
+eventlist_adaptive_choice(Eventlist_Ptr event_list)
+{
+  double scan;
+  int min_size, max_size;
 
-  while (event_list->size > 0) {
-    xfree((void*) simulation_run_get_event(this_simulation_run));
+  if (event_list->type == EVENTLIST_LIST) {
+    scan = (double) event_list->adaptive_scan / event_list->adaptive_inserts;
+    if (scan <= ADAPTIVE_LIST_MAX_SCAN)
+      return EVENTLIST_LIST;
+  } else {
+    scan = (double) (event_list->adaptive_inserts -
+		     event_list->adaptive_back_inserts) * event_list->size /
+      (2.0 * event_list->adaptive_inserts);
+    if (scan <= ADAPTIVE_LIST_MAX_SCAN / 2)
+      return EVENTLIST_LIST;
   }
 
-  /* Clean up the simulation_run. */
-  xfree(this_simulation_run->eventlist);
-  xfree(this_simulation_run->clock);
-  xfree(this_simulation_run);
+  min_size = ADAPTIVE_CALENDAR_MIN_SIZE;
+  max_size = ADAPTIVE_CALENDAR_MAX_SIZE;
+  if (event_list->type == EVENTLIST_CALENDAR) {
+    min_size /= 2;
+    max_size *= 2;
+  }
+  if (event_list->size >= min_size && event_list->size < max_size)
+    return EVENTLIST_CALENDAR;
+  return EVENTLIST_HEAP;
 }
 
 /*
- * Functions for handling various event list operations.
- *
- * Create a new event list. This is called when a simulation_run is
- * created. The event list is included in the simulation_run.
+ * Move every event in the structure to a structure of another type. The
+ * events are gathered, sorted and inserted in order, which is O(1) per event
+ * for the list and the heap. The calendar queue and radix heap start again
+ * from the current time, since a new event can be scheduled anywhere from
+ * there on, and the calendar takes its day width from the spread of the
+ * events it is given. The events are gathered in a scratch array that is
+ * kept from one switch to the next and only grows with the slot capacity.
  */
 
-static Eventlist_Ptr
-eventlist_new(void)
+static void
+eventlist_migrate(Eventlist_Ptr event_list, Eventlist_Type type, Sim_Time now)
 {
-  Eventlist_Ptr new_event_list;
+  Event_Heap_Entry * entries;
+  double spread;
+  int count = 0;
+  int i, buckets, slot;
+
+  if (event_list->scratch_capacity < event_list->capacity) {
+    event_list->scratch = (Event_Heap_Entry *)
+      arena_realloc(event_list->arena, event_list->scratch,
+		    event_list->scratch_capacity * sizeof(Event_Heap_Entry),
+		    event_list->capacity * sizeof(Event_Heap_Entry));
+    event_list->scratch_capacity = event_list->capacity;
+  }
+  entries = event_list->scratch;
+
+  buckets = CALENDAR_MIN_BUCKETS;
+  while (buckets < event_list->size / 2)
+    buckets *= 2;
+  if (type == EVENTLIST_CALENDAR)
+    eventlist_calendar_reserve(event_list, buckets);
+
+  switch (event_list->type) {
+  case EVENTLIST_HEAP:
+    for (i=0; i<event_list->size; i++)
+      entries[count++] = event_list->heap[i];
+    break;
+  case EVENTLIST_CALENDAR:
+    for (i=0; i<event_list->calendar_buckets; i++)
+      for (slot = event_list->calendar[i]; slot != NO_SLOT;
+	   slot = event_list->next[slot]) {
+	entries[count].key = event_list->keys[slot];
+	entries[count++].slot = slot;
+      }
+    break;
+  case EVENTLIST_RADIX:
+    for (i=0; i<RADIX_BUCKETS; i++)
+      for (slot = event_list->radix_head[i]; slot != NO_SLOT;
+	   slot = event_list->next[slot]) {
+	entries[count].key = event_list->keys[slot];
+	entries[count++].slot = slot;
+      }
+    break;
+  default:
+    for (slot = event_list->front; slot != NO_SLOT;
+	 slot = event_list->next[slot]) {
+      entries[count].key = event_list->keys[slot];
+      entries[count++].slot = slot;
+    }
+    break;
+  }
 
-  new_event_list = (Eventlist_Ptr) xmalloc(sizeof(Eventlist));
+  qsort(entries, count, sizeof(Event_Heap_Entry), event_heap_entry_compare);
+
+  event_list->type = type;
+  event_list->size = 0;
+
+  switch (type) {
+  case EVENTLIST_CALENDAR:
+    for (i=0; i<buckets; i++)
+      event_list->calendar[i] = NO_SLOT;
+    event_list->calendar_buckets = buckets;
+    if (count >= 2) {
+      spread = (double) (entries[count-1].key.occurrence_time -
+			 entries[0].key.occurrence_time);
+      if (spread > 0) {
+	event_list->calendar_mean_gap = spread / count;
+	event_list->calendar_width = 3.0 * event_list->calendar_mean_gap;
+      }
+    }
+    event_list->calendar_last_time = now;
+    event_list->calendar_current = eventlist_calendar_day(event_list, now);
+    break;
+  case EVENTLIST_RADIX:
+    for (i=0; i<RADIX_BUCKETS; i++) {
+      event_list->radix_head[i] = NO_SLOT;
+      event_list->radix_tail[i] = NO_SLOT;
+    }
+    event_list->radix_last = eventlist_radix_key(now);
+    event_list->radix_min = NO_SLOT;
+    break;
+  case EVENTLIST_LIST:
+    event_list->front = NO_SLOT;
+    event_list->back = NO_SLOT;
+    break;
+  default:
+    break;
+  }
 
-  new_event_list->front_ptr = NULL;
-  new_event_list->back_ptr = NULL;
-  new_event_list->size = 0;
-  return new_event_list;
+  for (i=0; i<count; i++)
+    eventlist_insert(event_list, entries[i].slot);
 }
 
-/*
- * Get a pointer to the eventlist. This is intended for use only by simlib.
- */
-
-static Eventlist_Ptr
-simulation_run_get_eventlist(Simulation_Run_Ptr simulation_run)
+static int
+event_heap_entry_compare(const void * first, const void * second)
 {
-  return simulation_run->eventlist;
+  const Event_Heap_Entry * first_entry = (const Event_Heap_Entry *) first;
+  const Event_Heap_Entry * second_entry = (const Event_Heap_Entry *) second;
+
+  if (first_entry->key.occurrence_time != second_entry->key.occurrence_time)
+    return first_entry->key.occurrence_time <
+      second_entry->key.occurrence_time ? -1 : 1;
+  if (first_entry->key.event_id != second_entry->key.event_id)
+    return first_entry->key.event_id < second_entry->key.event_id ? -1 : 1;
+  return 0;
 }
 
 /*
@@ -397,9 +1962,9 @@ simulation_run_get_eventlist(Simulation_Run_Ptr simulation_run)
 #ifdef TRACE_ON
 
 static void
-event_print_type(Event event)
+event_print_type(FILE * output, const char * description)
 {
-  printf("%s ", event.description);
+  fprintf(output, "%s ", description);
 }
 
 #endif /* TRACE_ON */
@@ -408,18 +1973,32 @@ event_print_type(Event event)
  * FIFO queue functions
  *
  * Make a new (empty) FIFO queue. This will return a pointer to the created
- * Fifoqueue. The FIFO queue is a singly linked list.
+ * Fifoqueue. The FIFO queue is a ring buffer of content pointers.
  */
 
 Fifoqueue_Ptr
 fifoqueue_new(void)
+{
+  return fifoqueue_new_in_arena(NULL);
+}
+
+/*
+ * Make a new FIFO queue in an arena (or on the heap if the arena is NULL).
+ */
+
+Fifoqueue_Ptr
+fifoqueue_new_in_arena(Arena_Ptr arena)
 {
   Fifoqueue_Ptr queue_id;
 
-  queue_id = (Fifoqueue_Ptr) xmalloc(sizeof(Fifoqueue));
+  queue_id = (Fifoqueue_Ptr) arena_alloc(arena, sizeof(Fifoqueue));
+  queue_id->arena = arena;
+  queue_id->ring = (void **)
+    arena_alloc(arena, FIFOQUEUE_INITIAL_SIZE * sizeof(void *));
+  queue_id->capacity = FIFOQUEUE_INITIAL_SIZE;
+  queue_id->front = 0;
   queue_id->size = 0;
-  queue_id->front_ptr = NULL;
-  queue_id->back_ptr  = NULL;
+  queue_id->shrink = 0;
   return queue_id;
 }
 
@@ -431,20 +2010,11 @@ fifoqueue_new(void)
 void
 fifoqueue_put(Fifoqueue_Ptr queue_ptr, void * content_ptr)
 {
-  Queue_Container_Ptr queue_container_ptr;
-
-  queue_container_ptr = (Queue_Container_Ptr) xmalloc(sizeof(Queue_Container));
-  queue_container_ptr->content_ptr = content_ptr;
-  queue_container_ptr->next_ptr = NULL;
+  if (queue_ptr->size == queue_ptr->capacity)
+    fifoqueue_resize(queue_ptr, 2 * queue_ptr->capacity);
 
-  if (queue_ptr->size == 0) {
-    queue_ptr->front_ptr = queue_container_ptr;
-    queue_ptr->back_ptr =  queue_container_ptr;
-  }
-  else {
-    queue_ptr->back_ptr->next_ptr = queue_container_ptr;
-    queue_ptr->back_ptr = queue_container_ptr;
-  }
+  queue_ptr->ring[(queue_ptr->front + queue_ptr->size) &
+		  (queue_ptr->capacity - 1)] = content_ptr;
   queue_ptr->size++;
 }
 
@@ -456,17 +2026,17 @@ fifoqueue_put(Fifoqueue_Ptr queue_ptr, void * content_ptr)
 void *
 fifoqueue_get(Fifoqueue_Ptr queue_ptr)
 {
-  Queue_Container_Ptr removed_container_ptr;
   void* content_ptr;
 
   if (queue_ptr->size > 0) {
-    removed_container_ptr = queue_ptr->front_ptr;
-    queue_ptr->front_ptr = removed_container_ptr->next_ptr;
-    content_ptr = removed_container_ptr->content_ptr;
-    free((char*) removed_container_ptr);
-
-    if(queue_ptr->size == 1) queue_ptr->back_ptr = NULL;
+    content_ptr = queue_ptr->ring[queue_ptr->front];
+    queue_ptr->front = (queue_ptr->front + 1) & (queue_ptr->capacity - 1);
     queue_ptr->size--;
+
+    if (queue_ptr->shrink && queue_ptr->arena == NULL &&
+	queue_ptr->capacity > FIFOQUEUE_INITIAL_SIZE &&
+	queue_ptr->size < queue_ptr->capacity / 4)
+      fifoqueue_resize(queue_ptr, queue_ptr->capacity / 2);
   }
   else {
     content_ptr = NULL;
@@ -485,13 +2055,83 @@ fifoqueue_size(Fifoqueue_Ptr queue_ptr)
 }
 
 /*
- * Get a pointer to the object at the front of the Fifoqueue.
+ * Get a pointer to the object at the front of the Fifoqueue (NULL if it is
+ * empty).
  */
 
 void*
 fifoqueue_see_front(Fifoqueue_Ptr queue_ptr)
 {
-  return queue_ptr->front_ptr->content_ptr;
+  if (queue_ptr->size == 0)
+    return NULL;
+  return queue_ptr->ring[queue_ptr->front];
+}
+
+/*
+ * Empty a Fifoqueue, keeping its ring. Anything still on it is not freed.
+ */
+
+void
+fifoqueue_reset(Fifoqueue_Ptr queue_ptr)
+{
+  queue_ptr->front = 0;
+  queue_ptr->size = 0;
+}
+
+/*
+ * Turn shrinking of the ring buffer on (nonzero) or off. It has no effect on a
+ * queue in an arena.
+ */
+
+void
+fifoqueue_set_shrink(Fifoqueue_Ptr queue_ptr, int shrink)
+{
+  queue_ptr->shrink = shrink;
+}
+
+/*
+ * Free a Fifoqueue. Anything still on it is not freed. A Fifoqueue in an arena
+ * can also be left to be released with the arena.
+ */
+
+void
+fifoqueue_free(Fifoqueue_Ptr queue_ptr)
+{
+  arena_free(queue_ptr->arena, queue_ptr->ring,
+	     queue_ptr->capacity * sizeof(void *));
+  arena_free(queue_ptr->arena, queue_ptr, sizeof(Fifoqueue));
+}
+
+/*
+ * Move the contents of a Fifoqueue to a new ring of the given size, with the
+ * front of the queue at the start of the ring. In an arena the old ring
+ * cannot be reclaimed, since the new one is allocated after it, but as the
+ * ring only grows there, the rings left behind add up to less than the one in
+ * use.
+ */
+
+static void
+fifoqueue_resize(Fifoqueue_Ptr queue_ptr, int capacity)
+{
+  void ** ring;
+  int first_part;
+
+  ring = (void **) arena_alloc(queue_ptr->arena, capacity * sizeof(void *));
+
+  first_part = queue_ptr->capacity - queue_ptr->front;
+  if (first_part > queue_ptr->size)
+    first_part = queue_ptr->size;
+
+  memcpy(ring, queue_ptr->ring + queue_ptr->front,
+	 first_part * sizeof(void *));
+  memcpy(ring + first_part, queue_ptr->ring,
+	 (queue_ptr->size - first_part) * sizeof(void *));
+
+  arena_free(queue_ptr->arena, queue_ptr->ring,
+	     queue_ptr->capacity * sizeof(void *));
+  queue_ptr->ring = ring;
+  queue_ptr->capacity = capacity;
+  queue_ptr->front = 0;
 }
 
 /*
@@ -502,10 +2142,20 @@ fifoqueue_see_front(Fifoqueue_Ptr queue_ptr)
 
 Server_Ptr
 server_new(void)
+{
+  return server_new_in_arena(NULL);
+}
+
+/*
+ * Create a server in an arena (or on the heap if the arena is NULL).
+ */
+
+Server_Ptr
+server_new_in_arena(Arena_Ptr arena)
 {
   Server_Ptr server_ptr;
 
-  server_ptr = (Server_Ptr) xmalloc(sizeof(Server));
+  server_ptr = (Server_Ptr) arena_alloc(arena, sizeof(Server));
   server_ptr->customer_in_service = NULL;
   server_ptr->state = FREE;
   return server_ptr;
@@ -560,6 +2210,18 @@ server_state(Server_Ptr a_server)
   return(a_server->state);
 }
 
+/*
+ * Put a server back in the FREE state with no customer, ready for another
+ * run.
+ */
+
+void
+server_reset(Server_Ptr a_server)
+{
+  a_server->state = FREE;
+  a_server->customer_in_service = NULL;
+}
+
 /*
  * Random number generator functions.
  */
@@ -582,7 +2244,7 @@ rand_stream_new(unsigned seed)
 void
 rand_stream_initialize(Rand_Stream_Ptr rand_stream, unsigned seed)
 {
-  rand_stream->rand_max = 32767;
+  rand_stream->rand_max = RAND_STREAM_MAX;
   rand_stream->seed  = seed;
   rand_stream->next = seed;
 }
@@ -595,7 +2257,7 @@ rand_stream_initialize(Rand_Stream_Ptr rand_stream, unsigned seed)
 unsigned
 rand_stream_get(Rand_Stream_Ptr rand_stream)
 {
-  rand_stream->next = rand_stream->next * 1103515245 + 12345;
+  rand_stream->next = rand_stream->next * RAND_STREAM_A + RAND_STREAM_C;
   return((unsigned)(rand_stream->next/65536) % rand_stream->rand_max);
 }
 
@@ -629,6 +2291,32 @@ random_generator_initialize(unsigned iseed)
   srand(iseed);
 }
 
+/*
+ * Random number functions that use the simulation_run's own stream. Unlike
+ * uniform_generator and exponential_generator, which share the state of the
+ * library rand(), these can be used by simulation_runs on different threads.
+ */
+
+void
+simulation_run_random_initialize(Simulation_Run_Ptr simulation_run,
+				 unsigned seed)
+{
+  rand_stream_initialize(simulation_run->rand_stream, seed);
+}
+
+double
+simulation_run_uniform_generator(Simulation_Run_Ptr simulation_run)
+{
+  return rand_stream_uniform_generator(simulation_run->rand_stream);
+}
+
+double
+simulation_run_exponential_generator(Simulation_Run_Ptr simulation_run,
+				     double mean)
+{
+  return rand_stream_exponential_generator(simulation_run->rand_stream, mean);
+}
+
 /*
  * Generate a random number uniformly distributed over (0, 1).
  */
@@ -661,6 +2349,201 @@ exponential_generator(double mean)
   return -1.0 * log(u) * mean;
 }
 
+/*
+ * Arena functions.
+ *
+ * Allocation sizes are rounded up to ARENA_ALIGNMENT. Each block starts with
+ * its Arena_Block header, and the Arena itself is kept at the start of the
+ * first block. The newest block is at the head of the list and is the only one
+ * allocated from.
+ */
+
+#define ARENA_ALIGN(size) \
+  (((size) + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1))
+
+Arena_Ptr
+arena_new(void)
+{
+  Arena_Block * block;
+  Arena_Ptr arena;
+
+  block = arena_block_new(ARENA_BLOCK_SIZE);
+  arena = (Arena_Ptr) ((char *) block + block->used);
+  block->used += ARENA_ALIGN(sizeof(Arena));
+
+  arena->blocks = block;
+  arena->last = NULL;
+  arena->bytes = block->used;
+  arena->peak_bytes = block->used;
+  arena->reserved_bytes = block->size;
+  return arena;
+}
+
+void *
+arena_alloc(Arena_Ptr arena, size_t size)
+{
+  Arena_Block * block;
+  size_t block_size;
+  void * ptr;
+
+  if (arena == NULL)
+    return xmalloc(size);
+
+  size = ARENA_ALIGN(size);
+  block = arena->blocks;
+
+  if (block->size - block->used < size) {
+    block_size = ARENA_ALIGN(sizeof(Arena_Block)) + size;
+    if (block_size < ARENA_BLOCK_SIZE)
+      block_size = ARENA_BLOCK_SIZE;
+
+    block = arena_block_new(block_size);
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->bytes += block->used;
+    arena->reserved_bytes += block->size;
+  }
+
+  ptr = (char *) block + block->used;
+  block->used += size;
+  arena->bytes += size;
+  if (arena->bytes > arena->peak_bytes)
+    arena->peak_bytes = arena->bytes;
+  arena->last = ptr;
+  return ptr;
+}
+
+/*
+ * Resize an allocation. The most recent allocation is extended in place if
+ * there is room in its block. Otherwise the contents are copied to a new
+ * allocation.
+ */
+
+void *
+arena_realloc(Arena_Ptr arena, void * ptr, size_t old_size, size_t size)
+{
+  Arena_Block * block;
+  size_t offset;
+  void * new_ptr;
+
+  if (arena == NULL)
+    return xrealloc(ptr, size);
+
+  if (ptr == NULL)
+    return arena_alloc(arena, size);
+
+  if (ptr == arena->last) {
+    block = arena->blocks;
+    offset = (char *) ptr - (char *) block;
+    if (offset + ARENA_ALIGN(size) <= block->size) {
+      arena->bytes += ARENA_ALIGN(size) - (block->used - offset);
+      if (arena->bytes > arena->peak_bytes)
+	arena->peak_bytes = arena->bytes;
+      block->used = offset + ARENA_ALIGN(size);
+      return ptr;
+    }
+  }
+
+  new_ptr = arena_alloc(arena, size);
+  memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+  return new_ptr;
+}
+
+/*
+ * Free an allocation of size bytes. Only the most recent allocation is
+ * actually reclaimed, and only if it still ends at the top of its block.
+ */
+
+void
+arena_free(Arena_Ptr arena, void * ptr, size_t size)
+{
+  Arena_Block * block;
+  size_t offset;
+
+  if (arena == NULL) {
+    xfree(ptr);
+    return;
+  }
+
+  if (ptr != NULL && ptr == arena->last) {
+    block = arena->blocks;
+    offset = (char *) ptr - (char *) block;
+    if (offset + ARENA_ALIGN(size) == block->used) {
+      arena->bytes -= ARENA_ALIGN(size);
+      block->used = offset;
+      arena->last = NULL;
+    }
+  }
+}
+
+/*
+ * Give back every block of an arena, including the arena itself.
+ */
+
+void
+arena_release(Arena_Ptr arena)
+{
+  Arena_Block * block, * next_block;
+
+  for (block = arena->blocks; block != NULL; block = next_block) {
+    next_block = block->next;
+    arena_block_free(block);
+  }
+}
+
+/*
+ * Get the largest number of bytes that were in use in an arena at once
+ * (including block headers), and the number of bytes held in its blocks.
+ */
+
+size_t
+arena_peak_bytes(Arena_Ptr arena)
+{
+  return arena->peak_bytes;
+}
+
+size_t
+arena_reserved_bytes(Arena_Ptr arena)
+{
+  return arena->reserved_bytes;
+}
+
+static Arena_Block *
+arena_block_new(size_t size)
+{
+  Arena_Block * block;
+
+#if defined(SIMLIB_ARENA_HUGEPAGES) && defined(__linux__)
+  size = (size + ARENA_HUGEPAGE_SIZE - 1) & ~(size_t) (ARENA_HUGEPAGE_SIZE - 1);
+  block = (Arena_Block *) mmap(NULL, size, PROT_READ | PROT_WRITE,
+			       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (block == (Arena_Block *) MAP_FAILED) {
+    printf("***** ERROR: Out of memory ***** \n");
+    exit(1);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(block, size, MADV_HUGEPAGE);
+#endif
+#else
+  block = (Arena_Block *) xmalloc(size);
+#endif
+
+  block->next = NULL;
+  block->size = size;
+  block->used = ARENA_ALIGN(sizeof(Arena_Block));
+  return block;
+}
+
+static void
+arena_block_free(Arena_Block * block)
+{
+#if defined(SIMLIB_ARENA_HUGEPAGES) && defined(__linux__)
+  munmap(block, block->size);
+#else
+  xfree(block);
+#endif
+}
+
 /*
  * Create a front-end fo malloc that performs out-of-memory testing.
  */
@@ -693,6 +2576,22 @@ xcalloc(unsigned num, unsigned size)
   }
 }
 
+/*
+ * Create a front-end for realloc that performs out-of-memory testing.
+ */
+
+void *
+xrealloc(void * ptr, unsigned size)
+{
+  void * a_ptr;
+
+  if((a_ptr = (void *) realloc(ptr, size)) != NULL) return a_ptr;
+  else {
+    printf("***** ERROR: Out of memory ***** \n");
+    exit(1);
+  }
+}
+
 /*
  * Create a front-end for free that checks for null pointers.
  */
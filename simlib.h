@@ -27,7 +27,45 @@
 
 /******************************************************************************/
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include "trace.h"
+
+/******************************************************************************/
+
+/*
+ * Simulation time. By default time is kept as a double in seconds. If
+ * SIMLIB_TICK_CLOCK is defined, the clock and event times are kept instead as
+ * an unsigned integer count of ticks (picoseconds by default). Fixed offsets
+ * such as transmission times then add up exactly without drift, and events are
+ * ordered on integer keys. simulation_run_get_time and
+ * simulation_run_schedule_event work in seconds in either mode. The _sim_time
+ * versions work in Sim_Time directly, and the macros below convert between the
+ * two.
+ */
+
+/* Uncomment the next statement to use the integer tick clock. */
+//#define SIMLIB_TICK_CLOCK
+
+#ifdef SIMLIB_TICK_CLOCK
+
+#define SIMLIB_TICKS_PER_SECOND 1E12
+
+typedef uint64_t Sim_Time;
+
+#define SIM_TIME_FROM_SECONDS(s) \
+  ((Sim_Time) ((s) * SIMLIB_TICKS_PER_SECOND + 0.5))
+#define SIM_TIME_TO_SECONDS(t) ((double) (t) / SIMLIB_TICKS_PER_SECOND)
+
+#else
+
+typedef double Sim_Time;
+
+#define SIM_TIME_FROM_SECONDS(s) ((double) (s))
+#define SIM_TIME_TO_SECONDS(t) ((double) (t))
+
+#endif /* SIMLIB_TICK_CLOCK */
 
 /******************************************************************************/
 
@@ -39,26 +77,56 @@
 struct _simulation_run_;
 struct _clock_;
 struct _event_;
-struct _event_container_;
-struct _event_list_;
+struct _event_key_;
+struct _event_payload_;
+struct _eventlist_;
+struct _eventlist_switch_;
+struct _rand_stream_;
+struct _arena_;
 
 /*
  * Define some convenient typedefs to use when writing simulation_runs.
  *
  * The simulation_run consists of an event list, clock and a pointer for
- * passing user data between various functions.
+ * passing user data between various functions. It also holds the next event
+ * id and its own random number stream, so that separate simulation_runs share
+ * no state and can be run at the same time on different threads. Everything
+ * that simlib allocates for a simulation_run comes from its arena.
  */
 
 typedef struct _simulation_run_
 {
   struct _eventlist_ * eventlist;
   struct _clock_ * clock;
+  struct _rand_stream_ * rand_stream;
+  struct _arena_ * arena;
+  long int next_event_id;
+  long int events_executed;
+  int predicate_interval;
   void * data;
+  FILE * output;
 } Simulation_Run, * Simulation_Run_Ptr;
 
+/*
+ * simulation_run_run_until executes events until one of its stopping
+ * conditions holds, and returns which one it was. The predicate is passed the
+ * simulation_run and a user context pointer, and returns nonzero to stop. It is
+ * checked before the first event and then every predicate_interval events
+ * (1 unless changed with simulation_run_set_predicate_interval).
+ */
+
+typedef enum {
+  SIMULATION_RUN_STOP_NO_EVENTS,
+  SIMULATION_RUN_STOP_HORIZON,
+  SIMULATION_RUN_STOP_MAX_EVENTS,
+  SIMULATION_RUN_STOP_PREDICATE
+} Simulation_Run_Stop_Reason;
+
+typedef int (* Simulation_Run_Predicate)(struct _simulation_run_ *, void *);
+
 typedef struct _clock_
 {
-  double time;
+  Sim_Time time;
 } Clock, * Clock_Ptr;
 
 /*
@@ -73,47 +141,233 @@ typedef struct _event_
   void * attachment;
 } Event, * Event_Ptr;
 
-typedef struct _event_container_
+/*
+ * Events can also be scheduled by kind, with
+ * simulation_run_schedule_kind_event. Such an event has no event function. It
+ * carries a kind number (greater than 0) and a 32 bit payload, and is taken
+ * off the event list with simulation_run_next_event, which returns both to the
+ * caller. The caller dispatches on the kind itself, normally with a switch, so
+ * that its event functions are called directly rather than through a function
+ * pointer. When simulation_run_next_event takes an ordinary event it calls the
+ * event function itself and returns EVENT_KIND_FUNCTION. If there are no
+ * events it returns EVENT_KIND_NONE. Kind events cannot be executed by
+ * simulation_run_execute_event or simulation_run_run_until.
+ */
+
+#define EVENT_KIND_FUNCTION 0
+#define EVENT_KIND_NONE (-1)
+
+/*
+ * Scheduled events are stored by slot in parallel arrays. The ordering key of
+ * each event (its occurrence time and event_id) is kept in a dense array of
+ * Event_Keys, which is all that the event list structures look at when
+ * ordering events. The heap stores a copy of each key next to its slot, as an
+ * Event_Heap_Entry. The event function and attachment are kept in a separate
+ * array of Event_Payloads which is only read when the event occurs. The
+ * description is only needed for tracing and is not stored otherwise.
+ */
+
+typedef struct _event_key_
 {
-  struct _event_container_ * next_container;
-  struct _event_container_ * previous_container;
-  struct _event_ event;
-  double occurrence_time;
-  void * data_ptr;
+  Sim_Time occurrence_time;
   long int event_id;
-} Event_Container, * Event_Container_Ptr;
+} Event_Key;
+
+typedef struct _event_heap_entry_
+{
+  struct _event_key_ key;
+  int slot;
+} Event_Heap_Entry;
+
+typedef struct _event_payload_
+{
+  void (* function)(struct _simulation_run_*, void *);
+  void * attachment;
+  int kind;
+#ifdef TRACE_ON
+  const char * description;
+#endif
+} Event_Payload;
+
+/*
+ * A handle to a scheduled event. This is returned by
+ * simulation_run_schedule_event and can be passed to
+ * simulation_run_deschedule_event to cancel the event without searching the
+ * event list. Descheduling an event that has already occurred or been
+ * descheduled is detected and reported as an error.
+ */
+
+typedef struct _event_handle_
+{
+  int slot;
+  long int event_id;
+} Event_Handle;
+
+/*
+ * The event list can be kept as a sorted doubly linked list, as an
+ * array-backed d-ary heap, as a calendar queue or as a radix heap. All of them
+ * give the same event ordering: events occur in order of occurrence time, and
+ * events scheduled for the same time occur in the order that they were
+ * scheduled (i.e., by event_id).
+ *
+ * The calendar queue hashes each event into a bucket by its occurrence time
+ * and keeps every bucket as a sorted list. The number of buckets follows the
+ * number of pending events, and the bucket width (in Sim_Time units) is set
+ * from the observed gaps between successive events.
+ *
+ * The radix heap relies on events never being scheduled before the last event
+ * removed. Each occurrence time is mapped to a 64 bit integer key (the tick
+ * count itself, or the bit pattern of the double, which sorts the same way
+ * for non-negative values), and an event is kept in bucket b, where b - 1 is
+ * the highest bit in which its key differs from the key of the last removed
+ * event (bucket 0 holds keys equal to it). When bucket 0 runs out, the lowest
+ * non-empty bucket is emptied into the buckets below it. Each event moves
+ * down at most 64 times, so its cost does not depend on the number of pending
+ * events. Bucket 0 is kept in event_id order.
+ *
+ * Whatever the structure, events that are scheduled for the current clock
+ * time bypass it and go on a separate FIFO "now" queue.
+ */
+
+typedef enum {EVENTLIST_LIST, EVENTLIST_HEAP, EVENTLIST_CALENDAR,
+	      EVENTLIST_RADIX} Eventlist_Type;
+
+#define EVENTLIST_HEAP_ARITY 4
+
+#define CALENDAR_MIN_BUCKETS 8
+#define CALENDAR_INITIAL_WIDTH 1.0
+#define CALENDAR_GAP_WEIGHT 16
+#define CALENDAR_RECALIBRATE_INTERVAL 1024
+
+#define RADIX_BUCKETS 65
+
+/*
+ * Adaptive selection. If it is turned on with
+ * simulation_run_set_eventlist_adaptive, the event list keeps statistics over
+ * each window of ADAPTIVE_WINDOW insertions. These are the number of pending
+ * events and where new events fall: how many go behind every other pending
+ * event, and (while it is the list) how many events the list stepped past to
+ * place them. At the end of each window the cheapest structure is chosen:
+ *
+ * - the list, if its mean insertion scan is at most ADAPTIVE_LIST_MAX_SCAN
+ *   (for the other structures the scan is estimated as half the pending events
+ *   for every insertion that does not go to the back, and must be at most half
+ *   the limit),
+ * - the calendar queue, for ADAPTIVE_CALENDAR_MIN_SIZE up to
+ *   ADAPTIVE_CALENDAR_MAX_SIZE pending events (a factor of two wider once it is
+ *   in use),
+ * - otherwise the heap.
+ *
+ * If that is not the current structure, the pending events are moved to the
+ * new one and the switch is logged. The event ordering is not affected.
+ */
+
+#define ADAPTIVE_WINDOW 256
+#define ADAPTIVE_LIST_MAX_SCAN 8
+#define ADAPTIVE_CALENDAR_MIN_SIZE 1024
+#define ADAPTIVE_CALENDAR_MAX_SIZE 65536
+
+typedef struct _eventlist_switch_
+{
+  Sim_Time time;
+  long int events_executed;
+  Eventlist_Type from;
+  Eventlist_Type to;
+  int size;
+} Eventlist_Switch;
+
+/*
+ * The event list owns the event storage. Unused slots are kept on a free list
+ * (linked through next) and the storage doubles when the free list runs
+ * out. Nothing is given back to the system until simulation_run_free_memory is
+ * called. The request and hit counters give the fraction of slots that were
+ * served from the free list.
+ *
+ * The list, calendar buckets, radix heap buckets and now queue link slots
+ * through the next and previous arrays.
+ */
+
+#define EVENT_POOL_INITIAL_SIZE 64
 
 typedef struct _eventlist_
 {
-  struct _event_container_ * front_ptr;
-  struct _event_container_ * back_ptr;
+  struct _arena_ * arena;
+  Eventlist_Type type;
+  Eventlist_Type configured_type;
+
+  struct _event_key_ * keys;
+  struct _event_payload_ * payloads;
+  int * next;
+  int * previous;
+  int * position;
+  int capacity;
+  int free_slot;
+  long int requests;
+  long int hits;
+
+  int front;
+  int back;
+
+  struct _event_heap_entry_ * heap;
+  struct _event_heap_entry_ * scratch;
+  int scratch_capacity;
+
+  int * calendar;
+  int calendar_capacity;
+  int calendar_buckets;
+  double calendar_width;
+  long long calendar_current;
+  Sim_Time calendar_last_time;
+  double calendar_mean_gap;
+  long int calendar_dequeues;
+
+  int radix_head[RADIX_BUCKETS];
+  int radix_tail[RADIX_BUCKETS];
+  uint64_t radix_last;
+  int radix_min;
+
+  int adaptive;
+  int adaptive_inserts;
+  int adaptive_back_inserts;
+  long int adaptive_scan;
+  Sim_Time adaptive_back_time;
+  struct _eventlist_switch_ * switches;
+  int switch_count;
+  int switch_capacity;
+
+  int now_front;
+  int now_back;
+  int now_size;
   int size;
 } Eventlist, * Eventlist_Ptr;
 
 /******************************************************************************/
 
 /*
- * FIFO queue object keeps the queue size and contains pointers to containers
- * at the front and back of the queue. The queue container objects are kept on
- * a singly linked list. Each container has a content pointer that tracks the
- * object placed on the FIFO queue.
+ * FIFO queue object keeps the queue size and a ring buffer of content pointers
+ * to the objects placed on the FIFO queue. The ring holds a power of two
+ * number of entries, starting at FIFOQUEUE_INITIAL_SIZE, and front is the
+ * index of the entry at the front of the queue. The ring doubles when it is
+ * full. If shrinking is turned on with fifoqueue_set_shrink, it is halved when
+ * it is less than a quarter full (but never below FIFOQUEUE_INITIAL_SIZE).
+ * Otherwise it keeps its largest size, so a queue that has reached its
+ * working size does no further allocation. A queue in an arena never shrinks,
+ * since the arena could not reuse the ring it gives back and each grow would
+ * then take a new one.
  */
 
-struct _queue_container_;
+#define FIFOQUEUE_INITIAL_SIZE 16
 
 typedef struct _fifoqueue_
 {
-  struct _queue_container_ * front_ptr;
-  struct _queue_container_ * back_ptr;
+  struct _arena_ * arena;
+  void ** ring;
+  int capacity;
+  int front;
   int size;
+  int shrink;
 } Fifoqueue, * Fifoqueue_Ptr;
 
-typedef struct _queue_container_
-{
-  void * content_ptr;
-  struct _queue_container_ * next_ptr;
-} Queue_Container, *Queue_Container_Ptr;
-
 /******************************************************************************/
 
 /*
@@ -130,6 +384,48 @@ typedef struct _server_
 
 /******************************************************************************/
 
+/*
+ * Memory arenas. An arena hands out memory from a list of large blocks by
+ * bumping a pointer, and all of it is given back at once by arena_release.
+ * arena_free and arena_realloc only reclaim or extend the most recent
+ * allocation in place. Anything else that is freed or outgrown stays in the
+ * arena until it is released, so arenas suit memory that is either kept for
+ * the life of the arena or grows geometrically.
+ *
+ * Blocks are ARENA_BLOCK_SIZE bytes, or larger if a single request needs it.
+ * If SIMLIB_ARENA_HUGEPAGES is defined (on Linux), blocks are
+ * ARENA_HUGEPAGE_SIZE bytes, mapped directly and advised to use transparent
+ * huge pages.
+ *
+ * The arena functions also accept a NULL arena, in which case they fall back
+ * on xmalloc, xrealloc and xfree.
+ */
+
+/* Uncomment the next statement to back arenas with huge pages. */
+//#define SIMLIB_ARENA_HUGEPAGES
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#define ARENA_ALIGNMENT 16
+
+typedef struct _arena_block_
+{
+  struct _arena_block_ * next;
+  size_t size;
+  size_t used;
+} Arena_Block;
+
+typedef struct _arena_
+{
+  struct _arena_block_ * blocks;
+  void * last;
+  size_t bytes;
+  size_t peak_bytes;
+  size_t reserved_bytes;
+} Arena, * Arena_Ptr;
+
+/******************************************************************************/
+
 /*
  * Random Number Generation
  *
@@ -140,9 +436,15 @@ typedef struct _server_
 
 /*
  * _rand_stream_ permits having multiple rand() streams at once. Multiple
- * Rand_Stream objects can be created and accessed via rand_stream_get.
+ * Rand_Stream objects can be created and accessed via rand_stream_get. Each
+ * stream is the linear congruential generator next = next * RAND_STREAM_A +
+ * RAND_STREAM_C (mod 2^32), returning (next >> 16) % RAND_STREAM_MAX.
  */
 
+#define RAND_STREAM_A 1103515245
+#define RAND_STREAM_C 12345
+#define RAND_STREAM_MAX 32767
+
 typedef struct _rand_stream_
 {
   unsigned seed;
@@ -163,12 +465,28 @@ typedef struct _rand_stream_
 Simulation_Run_Ptr
 simulation_run_new(void);
 
+void
+simulation_run_reset(Simulation_Run_Ptr);
+
 void
 simulation_run_execute_event(Simulation_Run_Ptr);
 
+Simulation_Run_Stop_Reason
+simulation_run_run_until(Simulation_Run_Ptr, double, long int,
+			 Simulation_Run_Predicate, void *);
+
+void
+simulation_run_set_predicate_interval(Simulation_Run_Ptr, int);
+
+long int
+simulation_run_events_executed(Simulation_Run_Ptr);
+
 double
 simulation_run_get_time(Simulation_Run_Ptr);
 
+Sim_Time
+simulation_run_get_sim_time(Simulation_Run_Ptr);
+
 void *
 simulation_run_data(Simulation_Run_Ptr);
 
@@ -178,15 +496,58 @@ simulation_run_set_data(Simulation_Run_Ptr, void*);
 /* Create an alias for simulation_run_set_data. */
 #define simulation_run_attach_data simulation_run_set_data
 
-long int
+FILE *
+simulation_run_output(Simulation_Run_Ptr);
+
+void
+simulation_run_set_output(Simulation_Run_Ptr, FILE *);
+
+void
+simulation_run_set_eventlist_type(Simulation_Run_Ptr, Eventlist_Type);
+
+Eventlist_Type
+simulation_run_eventlist_type(Simulation_Run_Ptr);
+
+void
+simulation_run_set_eventlist_adaptive(Simulation_Run_Ptr, int);
+
+int
+simulation_run_eventlist_switch_count(Simulation_Run_Ptr);
+
+Eventlist_Switch
+simulation_run_eventlist_switch(Simulation_Run_Ptr, int);
+
+const char *
+eventlist_type_name(Eventlist_Type);
+
+Event_Handle
 simulation_run_schedule_event(Simulation_Run_Ptr, Event, double);
 
+Event_Handle
+simulation_run_schedule_event_sim_time(Simulation_Run_Ptr, Event, Sim_Time);
+
+Event_Handle
+simulation_run_schedule_kind_event(Simulation_Run_Ptr, int, uint32_t,
+				   const char *, Sim_Time);
+
+int
+simulation_run_next_event(Simulation_Run_Ptr, uint32_t *);
+
 void *
-simulation_run_deschedule_event(Simulation_Run_Ptr, long int);
+simulation_run_deschedule_event(Simulation_Run_Ptr, Event_Handle);
+
+double
+simulation_run_event_pool_hit_rate(Simulation_Run_Ptr);
+
+Arena_Ptr
+simulation_run_arena(Simulation_Run_Ptr);
 
 Fifoqueue_Ptr
 fifoqueue_new(void);
 
+Fifoqueue_Ptr
+fifoqueue_new_in_arena(Arena_Ptr);
+
 void
 fifoqueue_put(Fifoqueue_Ptr, void*);
 
@@ -196,12 +557,24 @@ fifoqueue_get(Fifoqueue_Ptr);
 int
 fifoqueue_size(Fifoqueue_Ptr);
 
+void
+fifoqueue_reset(Fifoqueue_Ptr);
+
 void *
 fifoqueue_see_front(Fifoqueue_Ptr);
 
+void
+fifoqueue_set_shrink(Fifoqueue_Ptr, int);
+
+void
+fifoqueue_free(Fifoqueue_Ptr);
+
 Server_Ptr
 server_new(void);
 
+Server_Ptr
+server_new_in_arena(Arena_Ptr);
+
 void
 server_put(Server_Ptr, void*);
 
@@ -211,6 +584,9 @@ server_get(Server_Ptr);
 Server_State
 server_state(Server_Ptr);
 
+void
+server_reset(Server_Ptr);
+
 double
 exponential_generator(double);
 
@@ -220,6 +596,15 @@ uniform_generator(void);
 void
 random_generator_initialize(unsigned);
 
+void
+simulation_run_random_initialize(Simulation_Run_Ptr, unsigned);
+
+double
+simulation_run_uniform_generator(Simulation_Run_Ptr);
+
+double
+simulation_run_exponential_generator(Simulation_Run_Ptr, double);
+
 Rand_Stream_Ptr
 rand_stream_new(unsigned);
 
@@ -241,9 +626,33 @@ xmalloc(unsigned);
 void *
 xcalloc(unsigned, unsigned);
 
+void *
+xrealloc(void*, unsigned);
+
 void
 xfree(void*);
 
+Arena_Ptr
+arena_new(void);
+
+void *
+arena_alloc(Arena_Ptr, size_t);
+
+void *
+arena_realloc(Arena_Ptr, void *, size_t, size_t);
+
+void
+arena_free(Arena_Ptr, void *, size_t);
+
+void
+arena_release(Arena_Ptr);
+
+size_t
+arena_peak_bytes(Arena_Ptr);
+
+size_t
+arena_reserved_bytes(Arena_Ptr);
+
 void
 simulation_run_free_memory(Simulation_Run_Ptr);
 
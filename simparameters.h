@@ -31,23 +31,39 @@
 //#define FAST_RUN
 //#define NO_CSV_OUTPUT
 //#define D_D_1_system
+//#define TYPED_EVENT_DISPATCH
+//#define STATIC_TOPOLOGY_THREE_SWITCH
+
+/*
+ * The values below are the defaults of the run time configuration. Each of
+ * them can be changed when the program is started, from a config file or the
+ * command line, without recompiling (see config.h). FAST_RUN and D_D_1_system
+ * select the same presets as the fast_run and d_d_1_system settings.
+ */
 
 #define PACKET_ARRIVAL_RATE 750
 #define PACKET_ARRIVAL_RATE_SW2 500
 #define PACKET_ARRIVAL_RATE_SW3 500
 
-#ifdef FAST_RUN
+#define PACKET_LENGTH 1000 /* bits */
 
-#define P12_CUTOFF 0.99
+#define FAST_RUN_P12_CUTOFF 0.99
+#define FAST_RUN_RUNLENGTH 1E3 /* packets */
+#define FAST_RUN_RANDOM_SEED_LIST 400050636
 
-#define PACKET_LENGTH 1000 /* bits */
-#define RUNLENGTH 1E3 /* packets */
-#define RANDOM_SEED_LIST 400050636
+#define D_D_1_PACKET_XMT_TIME 0.002
+#define D_D_1_PACKET_XMT_TIME_SW2 0.003
+#define D_D_1_PACKET_XMT_TIME_SW3 0.003
+
+#ifdef FAST_RUN
+
+#define P12_CUTOFF FAST_RUN_P12_CUTOFF
+#define RUNLENGTH FAST_RUN_RUNLENGTH
+#define RANDOM_SEED_LIST FAST_RUN_RANDOM_SEED_LIST
 
 #else
 
 #define P12_CUTOFF 0.32, 0.35, 0.40, 0.5, 0.6, 0.65, 0.67
-#define PACKET_LENGTH 1000 /* bits */
 #define RUNLENGTH 100 /* packets */
 
 /* Comma separated list of random seeds to run. */
@@ -57,20 +73,25 @@
 
 #ifdef D_D_1_system
 
-#define PACKET_XMT_TIME 0.002
-#define PACKET_XMT_TIME_SW2 0.003
-#define PACKET_XMT_TIME_SW3 0.003
-#define BLIPRATE (RUNLENGTH/1000)
+#define PACKET_XMT_TIME D_D_1_PACKET_XMT_TIME
+#define PACKET_XMT_TIME_SW2 D_D_1_PACKET_XMT_TIME_SW2
+#define PACKET_XMT_TIME_SW3 D_D_1_PACKET_XMT_TIME_SW3
 
 #else
 
 #define PACKET_XMT_TIME ((double) PACKET_LENGTH/2E6)//((double) PACKET_LENGTH/LINK_BIT_RATE)
 #define PACKET_XMT_TIME_SW2 ((double) PACKET_LENGTH/1E6)//((double) PACKET_LENGTH/LINK_BIT_RATE)
 #define PACKET_XMT_TIME_SW3 ((double) PACKET_LENGTH/1E6)//((double) PACKET_LENGTH/LINK_BIT_RATE)
-#define BLIPRATE (RUNLENGTH/1000)
 
 #endif //D_D_1_system
 
+/*
+ * The most replications the lockstep engine runs side by side, and so the
+ * largest value of the lockstep setting.
+ */
+
+#define LOCKSTEP_MAX_LANES 16
+
 /******************************************************************************/
 
 #endif /* simparameters.h */
@@ -0,0 +1,209 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _STATIC_TOPOLOGY_H_
+#define _STATIC_TOPOLOGY_H_
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+#include "switch_events.h"
+
+/******************************************************************************/
+
+/*
+ * Compile-time specialized topologies. When one of the STATIC_TOPOLOGY_*
+ * options in simparameters.h is defined, the shape of the network is fixed
+ * when the program is compiled. That covers the number of switches, their
+ * arrival rates and transmission times, and their next hops.
+ * run_events_static() has a case for each switch and event kind, which calls
+ * the same event bodies as the run time path (see switch_events.h) with the
+ * switch id, arrival rate, transmission time and number of next hops as
+ * constants. The compiler inlines the bodies into the dispatch switch and
+ * folds the constants into them.
+ *
+ * Routing is fixed as far as the number of next hops goes. A switch with one
+ * next hop takes it without a draw, and one with a few has its scan of the
+ * cumulative probabilities unrolled, with no call to routing_table_choose().
+ * The probabilities themselves are not fixed, because main.c sweeps them.
+ * They come from the switch routing tables, as in the run time path. The
+ * switches are still set up by switches_new() and switches_reset() from the
+ * run time topology, which static_topology_check() compares against the
+ * compiled one. The compiled arrival rates and transmission times are the
+ * simparameters.h defaults, so a run time configuration that changes them is
+ * rejected. Each switch has its own event kinds (see SWITCH_EVENT_KIND), and
+ * the events are scheduled in the same order as in the run time path, so the
+ * results are identical.
+ *
+ * A static topology defines:
+ *
+ *   STATIC_SWITCH_COUNT           the number of switches
+ *   STATIC_ARRIVAL_RATE(id)       the source arrival rate of a switch
+ *   STATIC_XMT_TIME(id)           the transmission time of its link
+ *   STATIC_NEXT_HOP_COUNT(id)     its number of next hops
+ *   STATIC_NEXT_HOP(id, k)        its k-th next hop
+ *   STATIC_FOR_EACH_SWITCH(M)     M(id) for each switch id, as literals
+ */
+
+#ifdef STATIC_TOPOLOGY_THREE_SWITCH
+
+#define STATIC_TOPOLOGY
+
+#define STATIC_SWITCH_COUNT 3
+
+#define STATIC_ARRIVAL_RATE(id) \
+  ((id) == 0 ? PACKET_ARRIVAL_RATE : \
+   (id) == 1 ? PACKET_ARRIVAL_RATE_SW2 : PACKET_ARRIVAL_RATE_SW3)
+
+#define STATIC_XMT_TIME(id) \
+  ((id) == 0 ? PACKET_XMT_TIME : \
+   (id) == 1 ? PACKET_XMT_TIME_SW2 : PACKET_XMT_TIME_SW3)
+
+#define STATIC_NEXT_HOP_COUNT(id) ((id) == 0 ? 2 : 0)
+#define STATIC_NEXT_HOP(id, k) ((k) == 0 ? 1 : 2)
+
+#define STATIC_FOR_EACH_SWITCH(M) M(0) M(1) M(2)
+
+#endif /* STATIC_TOPOLOGY_THREE_SWITCH */
+
+/******************************************************************************/
+
+#ifdef STATIC_TOPOLOGY
+
+/*
+ * Check that the run time topology has the shape that was compiled in.
+ */
+
+static void
+static_topology_check(Topology_Ptr topology)
+{
+  Switch_Config * sw;
+  int id, k;
+
+  if (topology->switch_count != STATIC_SWITCH_COUNT) {
+    printf("Error: The topology does not match the static topology.\n");
+    exit(1);
+  }
+
+  for (id=0; id<STATIC_SWITCH_COUNT; id++) {
+    sw = &topology->switches[id];
+    if (sw->packet_arrival_rate != STATIC_ARRIVAL_RATE(id) ||
+	sw->packet_xmt_time != STATIC_XMT_TIME(id) ||
+	sw->next_hop_count != STATIC_NEXT_HOP_COUNT(id)) {
+      printf("Error: SW%d does not match the static topology.\n", id+1);
+      exit(1);
+    }
+    for (k=0; k<sw->next_hop_count; k++)
+      if (sw->next_hop[k] != STATIC_NEXT_HOP(id, k)) {
+	printf("Error: SW%d does not match the static topology.\n", id+1);
+	exit(1);
+      }
+  }
+}
+
+/*
+ * Schedule the first packet arrival at each switch that has a source, at the
+ * current time.
+ */
+
+static void
+static_topology_start(Simulation_Run_Ptr simulation_run)
+{
+  Simulation_Run_Data_Ptr data;
+  int id;
+
+  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+
+  for (id=0; id<STATIC_SWITCH_COUNT; id++)
+    if (STATIC_ARRIVAL_RATE(id) > 0)
+      switch_schedule_packet_arrival(simulation_run, data,
+			     simulation_run_get_sim_time(simulation_run), id, 1);
+}
+
+/*
+ * Execute events until there are none left or the predicate returns nonzero,
+ * as run_events_by_kind() does, with a case for each event kind and switch.
+ */
+
+#define STATIC_XMT_SIM_TIME(id) SIM_TIME_FROM_SECONDS(STATIC_XMT_TIME(id))
+
+#define STATIC_EVENT_CASES(id) \
+  case SWITCH_EVENT_KIND(PACKET_ARRIVAL_EVENT, id): \
+    switch_packet_arrival(simulation_run, data, id, STATIC_ARRIVAL_RATE(id), \
+			  STATIC_XMT_SIM_TIME(id), 1); \
+    break; \
+  case SWITCH_EVENT_KIND(FORWARDED_PACKET_ARRIVAL_EVENT, id): \
+    switch_forwarded_packet_arrival(simulation_run, data, \
+				    (Packet_Index) payload, id, \
+				    STATIC_XMT_SIM_TIME(id), 1); \
+    break; \
+  case SWITCH_EVENT_KIND(END_PACKET_TRANSMISSION_EVENT, id): \
+    switch_end_packet_transmission(simulation_run, data, id, \
+				   STATIC_NEXT_HOP_COUNT(id), \
+				   STATIC_XMT_SIM_TIME(id), 1); \
+    break;
+
+static Simulation_Run_Stop_Reason
+run_events_static(Simulation_Run_Ptr simulation_run,
+		  Simulation_Run_Predicate predicate, void * ctx)
+{
+  Simulation_Run_Data_Ptr data;
+  uint32_t payload;
+  int kind;
+
+  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+
+  for (;;) {
+
+    if ((*predicate)(simulation_run, ctx))
+      return SIMULATION_RUN_STOP_PREDICATE;
+
+    kind = simulation_run_next_event(simulation_run, &payload);
+
+    switch (kind) {
+
+    STATIC_FOR_EACH_SWITCH(STATIC_EVENT_CASES)
+
+    case EVENT_KIND_FUNCTION:
+      break;
+
+    case EVENT_KIND_NONE:
+      return SIMULATION_RUN_STOP_NO_EVENTS;
+
+    default:
+      printf("Error: Unknown event kind %d.\n", kind);
+      exit(1);
+    }
+  }
+}
+
+#endif /* STATIC_TOPOLOGY */
+
+/******************************************************************************/
+
+#endif /* static_topology.h */
+
@@ -0,0 +1,276 @@
+
+/*
+ *  
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#ifndef _SWITCH_EVENTS_H_
+#define _SWITCH_EVENTS_H_
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include "trace.h"
+#include "main.h"
+#include "packet_table.h"
+#include "output.h"
+#include "routing.h"
+#include "packet_arrival.h"
+#include "packet_transmission.h"
+
+/******************************************************************************/
+
+/*
+ * The bodies of the switch event functions. Each one takes the switch id and
+ * the parts of the switch configuration that it uses as arguments, rather
+ * than reading them from the switch: the arrival rate, the transmission time
+ * and the number of next hops. The event functions in packet_arrival.c and
+ * packet_transmission.c pass the run time values. A static topology (see
+ * static_topology.h) passes constants. Once a body is inlined, the compiler
+ * then folds the switch lookups, the arrival rate and the routing into the
+ * code for each switch.
+ *
+ * The events that a body schedules are made by the schedule_*_event()
+ * functions, unless switch_kinds is set. In that case every switch has its
+ * own event kinds, SWITCH_EVENT_KIND(kind, id), so that the dispatch also
+ * knows the switch id as a constant. The switch id is in the low 4 bits,
+ * since there can be up to MAX_SWITCHES (16) switches.
+ */
+
+#define SWITCH_EVENT_KIND(kind, id) (((kind) << 4) | (id))
+
+/*
+ * Schedule a packet arrival from the source of a switch.
+ */
+
+static inline void
+switch_schedule_packet_arrival(Simulation_Run_Ptr simulation_run,
+			       Simulation_Run_Data_Ptr data,
+			       Sim_Time event_time, const int id,
+			       const int switch_kinds)
+{
+  if (switch_kinds)
+    simulation_run_schedule_kind_event(simulation_run,
+	   SWITCH_EVENT_KIND(PACKET_ARRIVAL_EVENT, id), 0,
+	   data->switches[id].arrival_description, event_time);
+  else
+    schedule_packet_arrival_event(simulation_run, event_time,
+				  &data->switches[id]);
+}
+
+/*
+ * This function ititiates the transmission of the packet passed to the
+ * function. This is done by placing the packet in the server of the switch.
+ * The packet transmission end event for this packet is then scheduled.
+ */
+
+static inline void
+switch_start_transmission(Simulation_Run_Ptr simulation_run,
+			  Simulation_Run_Data_Ptr data,
+			  Packet_Index this_packet_index, const int id,
+			  const Sim_Time xmt_time, const int switch_kinds)
+{
+  Switch_Ptr sw = &data->switches[id];
+  Packet_Ptr this_packet;
+
+  TRACE(fprintf(simulation_run_output(simulation_run), "%s Start Of Packet.\n", sw->name);)
+
+  this_packet = PACKET_PTR(data->packets, this_packet_index);
+
+  server_put(sw->link, PACKET_INDEX_TO_VOID(this_packet_index));
+  this_packet->status = XMTTING;
+
+  /* Schedule the end of packet transmission event. */
+  if (switch_kinds)
+    simulation_run_schedule_kind_event(simulation_run,
+	   SWITCH_EVENT_KIND(END_PACKET_TRANSMISSION_EVENT, id), 0,
+	   sw->end_description,
+	   simulation_run_get_sim_time(simulation_run) + xmt_time);
+  else
+    schedule_end_packet_transmission_event(simulation_run,
+	   simulation_run_get_sim_time(simulation_run) + xmt_time, sw);
+}
+
+/*
+ * A packet arrives at a switch from its source. It creates a new packet
+ * object and places it in either the fifo queue if the server is busy.
+ * Otherwise it starts the transmission of the packet. It then schedules the
+ * next packet arrival event.
+ */
+
+static inline void
+switch_packet_arrival(Simulation_Run_Ptr simulation_run,
+		      Simulation_Run_Data_Ptr data, const int id,
+		      const double packet_arrival_rate, const Sim_Time xmt_time,
+		      const int switch_kinds)
+{
+  Switch_Ptr sw = &data->switches[id];
+  Packet_Index new_packet_index;
+  Packet_Ptr new_packet;
+
+  sw->arrival_count++;
+
+  new_packet_index = packet_new(data->packets);
+  new_packet = PACKET_PTR(data->packets, new_packet_index);
+  new_packet->source_id = id;
+  new_packet->switch_id = id;
+  new_packet->arrive_time = simulation_run_get_sim_time(simulation_run);
+  new_packet->status = WAITING;
+
+  /* 
+   * Start transmission if the data link is free. Otherwise put the packet into
+   * the buffer.
+   */
+
+  if(server_state(sw->link) == BUSY) {
+    packet_queue_put(data->packets, &sw->buffer, new_packet_index);
+  } else {
+    switch_start_transmission(simulation_run, data, new_packet_index, id,
+			      xmt_time, switch_kinds);
+  }
+
+  /* 
+   * Schedule the next packet arrival. Independent, exponentially distributed
+   * interarrival times gives us Poisson process arrivals.
+   */
+
+  if (data->config->d_d_1_system)
+    switch_schedule_packet_arrival(simulation_run, data, simulation_run_get_sim_time(simulation_run) + SIM_TIME_FROM_SECONDS((double) 1/packet_arrival_rate), id, switch_kinds);
+  else
+    switch_schedule_packet_arrival(simulation_run, data, simulation_run_get_sim_time(simulation_run) + SIM_TIME_FROM_SECONDS(simulation_run_exponential_generator(simulation_run, (double) 1/packet_arrival_rate)), id, switch_kinds);
+}
+
+/*
+ * A packet forwarded by another switch arrives. The packet keeps its
+ * source_id and arrive_time, so that its delay is measured from when it
+ * entered the network.
+ */
+
+static inline void
+switch_forwarded_packet_arrival(Simulation_Run_Ptr simulation_run,
+				Simulation_Run_Data_Ptr data,
+				Packet_Index packet_index, const int id,
+				const Sim_Time xmt_time,
+				const int switch_kinds)
+{
+  Switch_Ptr sw = &data->switches[id];
+
+  PACKET_PTR(data->packets, packet_index)->status = WAITING;
+
+  /* 
+   * Start transmission if the data link is free. Otherwise put the packet into
+   * the buffer.
+   */
+
+  if(server_state(sw->link) == BUSY) {
+    packet_queue_put(data->packets, &sw->buffer, packet_index);
+  } else {
+    switch_start_transmission(simulation_run, data, packet_index, id,
+			      xmt_time, switch_kinds);
+  }
+}
+
+/*
+ * The transmission of a packet on the link of a switch has ended. If the
+ * switch has next hops, the packet is forwarded to one of them. Otherwise it
+ * leaves the network, and the statistics of the switch it came from are
+ * updated. It then checks to see if there are other packets waiting in the
+ * fifo queue. If that is the case it starts the transmission of the next
+ * packet.
+ */
+
+static inline void
+switch_end_packet_transmission(Simulation_Run_Ptr simulation_run,
+			       Simulation_Run_Data_Ptr data, const int id,
+			       const int next_hop_count,
+			       const Sim_Time xmt_time,
+			       const int switch_kinds)
+{
+  Switch_Ptr sw = &data->switches[id];
+  Switch_Ptr source;
+  Packet_Index this_packet_index, next_packet;
+  Packet_Ptr this_packet;
+  int next_hop;
+
+  TRACE(fprintf(simulation_run_output(simulation_run), "%s End Of Packet.\n", sw->name););
+
+  /* 
+   * Packet transmission is finished. Take the packet off the data link.
+   */
+
+  this_packet_index = PACKET_INDEX_FROM_VOID(server_get(sw->link));
+  this_packet = PACKET_PTR(data->packets, this_packet_index);
+
+  if (next_hop_count > 0) {
+
+    fprintf(simulation_run_output(simulation_run), "sim time (msec) = %f \n",simulation_run_get_time(simulation_run)); 
+    fprintf(simulation_run_output(simulation_run), "ariive time (msec) = %f \n", SIM_TIME_TO_SECONDS(this_packet->arrive_time)); 
+    fprintf(simulation_run_output(simulation_run), "each packet_delay (msec) = %f \n",SIM_TIME_TO_SECONDS(simulation_run_get_sim_time(simulation_run) - this_packet->arrive_time));
+
+    /* Output activity blip every so often. */
+    output_progress_msg_to_screen(simulation_run, sw);
+
+    /* Send the packet on to the next switch. */
+    next_hop = routing_table_choose_count(simulation_run, &sw->routing,
+					  next_hop_count);
+    this_packet->switch_id = next_hop;
+    if (switch_kinds)
+      simulation_run_schedule_kind_event(simulation_run,
+	     SWITCH_EVENT_KIND(FORWARDED_PACKET_ARRIVAL_EVENT, next_hop),
+	     (uint32_t) this_packet_index,
+	     data->switches[next_hop].forward_description,
+	     simulation_run_get_sim_time(simulation_run));
+    else
+      schedule_forwarded_packet_arrival_event(simulation_run,
+		      simulation_run_get_sim_time(simulation_run),
+		      this_packet_index);
+
+  } else {
+
+    /* Collect statistics. */
+    source = &data->switches[this_packet->source_id];
+    source->number_of_packets_processed++;
+    source->accumulated_delay += SIM_TIME_TO_SECONDS(
+      simulation_run_get_sim_time(simulation_run) - this_packet->arrive_time);
+
+    /* Output activity blip every so often. */
+    output_progress_msg_to_screen(simulation_run, sw);
+
+    /* This packet is done ... give the memory back. */
+    packet_free(data->packets, this_packet_index);
+  }
+
+  /* 
+   * See if there is are packets waiting in the buffer. If so, take the next one
+   * out and transmit it immediately.
+  */
+
+  if(packet_queue_size(&sw->buffer) > 0) {
+    next_packet = packet_queue_get(data->packets, &sw->buffer);
+    switch_start_transmission(simulation_run, data, next_packet, id,
+			      xmt_time, switch_kinds);
+  }
+}
+
+/******************************************************************************/
+
+#endif /* switch_events.h */
@@ -0,0 +1,335 @@
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * Checks that every event list structure gives the same event ordering as the
+ * sorted list. The same workload is run on each structure: every event
+ * schedules zero, one or two new events and sometimes deschedules a pending
+ * one, at delays that include zero (the now queue), small whole numbers (so
+ * that many events share a time and are ordered by event_id) and exponential
+ * gaps. The number of pending events goes through phases from a handful to a
+ * few thousand. The workload draws from its own random number stream, so it
+ * only depends on the order in which events occur, and the order and times of
+ * every event must match the list exactly. With adaptive selection the phases
+ * make the events move from one structure to another, and the run must have
+ * moved them to the list, the heap and the calendar queue. Prints PASS and
+ * exits with 0, or prints the first event that differs and exits with 1.
+ *
+ * Build and run from the top of the tree:
+ *
+ *   gcc -O2 -I. -o eventlist_test tests/eventlist_test.c simlib.c -lm
+ *   ./eventlist_test
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "simlib.h"
+
+/******************************************************************************/
+
+#define EVENTLIST_TEST_EVENTS 140000L
+#define EVENTLIST_TEST_TAGS (2 * EVENTLIST_TEST_EVENTS + 16)
+#define EVENTLIST_TEST_SEED 400050636
+#define EVENTLIST_TEST_FIFO_DELAY 10.0
+#define EVENTLIST_TEST_MEAN_DELAY 100.0
+
+/*
+ * The pending event target and the kind of delays used for each phase, from
+ * the event count at which it starts. FIFO phases schedule every event at the
+ * same delay, so that new events go behind all the others.
+ */
+
+typedef struct _eventlist_test_phase_
+{
+  long int start;
+  int target;
+  int fifo;
+} Eventlist_Test_Phase;
+
+static const Eventlist_Test_Phase eventlist_test_phases[] = {
+  {0, 8, 1},
+  {20000, 3000, 0},
+  {80000, 200, 0},
+  {120000, 8, 1}
+};
+
+#define EVENTLIST_TEST_PHASE_COUNT \
+  ((int) (sizeof(eventlist_test_phases)/sizeof(eventlist_test_phases[0])))
+
+typedef struct _eventlist_test_case_
+{
+  const char * name;
+  Eventlist_Type type;
+  int adaptive;
+} Eventlist_Test_Case;
+
+static const Eventlist_Test_Case eventlist_test_cases[] = {
+  {"list", EVENTLIST_LIST, 0},
+  {"heap", EVENTLIST_HEAP, 0},
+  {"calendar", EVENTLIST_CALENDAR, 0},
+  {"radix", EVENTLIST_RADIX, 0},
+  {"adaptive list", EVENTLIST_LIST, 1},
+  {"adaptive radix", EVENTLIST_RADIX, 1}
+};
+
+#define EVENTLIST_TEST_CASE_COUNT \
+  ((int) (sizeof(eventlist_test_cases)/sizeof(eventlist_test_cases[0])))
+
+/*
+ * Each event is tagged with the order in which it was scheduled. The pending
+ * tags are kept in an unordered array, with the position of each tag in it, so
+ * that a random one can be descheduled.
+ */
+
+typedef struct _eventlist_test_run_
+{
+  Rand_Stream_Ptr workload;
+  Event_Handle * handles;
+  long int * pending;
+  long int * pending_index;
+  long int pending_count;
+  long int next_tag;
+  long int * trace_tags;
+  double * trace_times;
+  long int executed;
+  unsigned switched_to;
+} Eventlist_Test_Run;
+
+/******************************************************************************/
+
+static void
+eventlist_test_event(Simulation_Run_Ptr, void *);
+
+static void
+eventlist_test_pending_remove(Eventlist_Test_Run * run, long int tag)
+{
+  long int index = run->pending_index[tag];
+  long int last = run->pending[--run->pending_count];
+
+  run->pending[index] = last;
+  run->pending_index[last] = index;
+}
+
+static void
+eventlist_test_schedule(Simulation_Run_Ptr simulation_run,
+			Eventlist_Test_Run * run, double delay)
+{
+  Event event;
+  long int tag = run->next_tag++;
+
+  event.description = "Eventlist Test";
+  event.function = eventlist_test_event;
+  event.attachment = (void *) (uintptr_t) tag;
+
+  run->handles[tag] = simulation_run_schedule_event(simulation_run, event,
+			simulation_run_get_time(simulation_run) + delay);
+  run->pending_index[tag] = run->pending_count;
+  run->pending[run->pending_count++] = tag;
+}
+
+/*
+ * Pick the delay of a new event: zero one time in eight, otherwise a whole
+ * number from 1 to 3 one time in four, otherwise the phase delay.
+ */
+
+static double
+eventlist_test_delay(Eventlist_Test_Run * run, int fifo)
+{
+  double u = rand_stream_uniform_generator(run->workload);
+
+  if (u < 0.125)
+    return 0.0;
+  if (fifo)
+    return EVENTLIST_TEST_FIFO_DELAY;
+  if (u < 0.375)
+    return (double) (1 + (int) ((u - 0.125) * 12.0));
+  return -EVENTLIST_TEST_MEAN_DELAY *
+    log(rand_stream_uniform_generator(run->workload));
+}
+
+static void
+eventlist_test_event(Simulation_Run_Ptr simulation_run, void * attachment)
+{
+  Eventlist_Test_Run * run =
+    (Eventlist_Test_Run *) simulation_run_data(simulation_run);
+  const Eventlist_Test_Phase * phase = &eventlist_test_phases[0];
+  long int tag = (long int) (uintptr_t) attachment;
+  long int victim;
+  int children, p;
+
+  run->trace_tags[run->executed] = tag;
+  run->trace_times[run->executed] = simulation_run_get_time(simulation_run);
+  run->executed++;
+  eventlist_test_pending_remove(run, tag);
+
+  for (p = 0; p < EVENTLIST_TEST_PHASE_COUNT; p++)
+    if (run->executed >= eventlist_test_phases[p].start)
+      phase = &eventlist_test_phases[p];
+
+  if (run->pending_count < phase->target)
+    children = 2;
+  else if (run->pending_count > phase->target &&
+	   rand_stream_uniform_generator(run->workload) < 0.5)
+    children = 0;
+  else
+    children = 1;
+
+  while (children-- > 0)
+    eventlist_test_schedule(simulation_run, run,
+			    eventlist_test_delay(run, phase->fifo));
+
+  if (run->pending_count > 2 &&
+      rand_stream_uniform_generator(run->workload) < 0.0625) {
+    victim = run->pending[(long int) (run->pending_count *
+		  (rand_stream_uniform_generator(run->workload) - 1e-9))];
+    if (simulation_run_deschedule_event(simulation_run,
+			run->handles[victim]) != (void *) (uintptr_t) victim) {
+      printf("FAIL: descheduling event %ld returned another event.\n",
+	     victim);
+      exit(1);
+    }
+    eventlist_test_pending_remove(run, victim);
+  }
+}
+
+/*
+ * Run the workload on one event list structure and record the tag and time of
+ * every event in the order they occurred.
+ */
+
+static void
+eventlist_test_run(const Eventlist_Test_Case * test_case,
+		   Eventlist_Test_Run * run)
+{
+  Simulation_Run_Ptr simulation_run;
+  Eventlist_Switch eventlist_switch;
+  FILE * discard;
+  int i;
+
+  run->workload = rand_stream_new(EVENTLIST_TEST_SEED);
+  run->handles = (Event_Handle *)
+    xmalloc(EVENTLIST_TEST_TAGS * sizeof(Event_Handle));
+  run->pending = (long int *) xmalloc(EVENTLIST_TEST_TAGS * sizeof(long int));
+  run->pending_index = (long int *)
+    xmalloc(EVENTLIST_TEST_TAGS * sizeof(long int));
+  run->trace_tags = (long int *)
+    xmalloc(EVENTLIST_TEST_EVENTS * sizeof(long int));
+  run->trace_times = (double *) xmalloc(EVENTLIST_TEST_EVENTS * sizeof(double));
+  run->pending_count = 0;
+  run->next_tag = 0;
+  run->executed = 0;
+  run->switched_to = 0;
+
+  simulation_run = simulation_run_new();
+  simulation_run_attach_data(simulation_run, (void *) run);
+
+  discard = fopen("/dev/null", "w");
+  if (discard == NULL) {
+    printf("Error: Cannot open /dev/null.\n");
+    exit(1);
+  }
+  simulation_run_set_output(simulation_run, discard);
+
+  simulation_run_set_eventlist_type(simulation_run, test_case->type);
+  simulation_run_set_eventlist_adaptive(simulation_run, test_case->adaptive);
+
+  for (i = 0; i < 4; i++)
+    eventlist_test_schedule(simulation_run, run, (double) i);
+
+  simulation_run_run_until(simulation_run, -1.0, EVENTLIST_TEST_EVENTS,
+			   NULL, NULL);
+
+  printf("%s: %ld events, %d switches\n", test_case->name, run->executed,
+	 simulation_run_eventlist_switch_count(simulation_run));
+  for (i = 0; i < simulation_run_eventlist_switch_count(simulation_run); i++) {
+    eventlist_switch = simulation_run_eventlist_switch(simulation_run, i);
+    printf("  %s to %s after %ld events, %d pending\n",
+	   eventlist_type_name(eventlist_switch.from),
+	   eventlist_type_name(eventlist_switch.to),
+	   eventlist_switch.events_executed, eventlist_switch.size);
+    run->switched_to |= 1u << eventlist_switch.to;
+  }
+
+  simulation_run_free_memory(simulation_run);
+  fclose(discard);
+  xfree(run->workload);
+  xfree(run->handles);
+  xfree(run->pending);
+  xfree(run->pending_index);
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char ** argv)
+{
+  Eventlist_Test_Run reference, run;
+  int i, failed = 0;
+  long int k;
+
+  (void) argc;
+  (void) argv;
+
+  eventlist_test_run(&eventlist_test_cases[0], &reference);
+  if (reference.executed != EVENTLIST_TEST_EVENTS) {
+    printf("FAIL: the workload ran out of events after %ld.\n",
+	   reference.executed);
+    return 1;
+  }
+
+  for (i = 1; i < EVENTLIST_TEST_CASE_COUNT; i++) {
+    eventlist_test_run(&eventlist_test_cases[i], &run);
+    for (k = 0; k < reference.executed; k++)
+      if (k >= run.executed || run.trace_tags[k] != reference.trace_tags[k] ||
+	  run.trace_times[k] != reference.trace_times[k]) {
+	printf("FAIL: %s event %ld is %ld at %f, the list gives %ld at %f.\n",
+	       eventlist_test_cases[i].name, k,
+	       k < run.executed ? run.trace_tags[k] : -1L,
+	       k < run.executed ? run.trace_times[k] : -1.0,
+	       reference.trace_tags[k], reference.trace_times[k]);
+	failed = 1;
+	break;
+      }
+    if (eventlist_test_cases[i].adaptive &&
+	run.switched_to != (1u << EVENTLIST_LIST | 1u << EVENTLIST_HEAP |
+			    1u << EVENTLIST_CALENDAR)) {
+      printf("FAIL: %s did not move the events to every structure it can "
+	     "choose.\n", eventlist_test_cases[i].name);
+      failed = 1;
+    }
+    xfree(run.trace_tags);
+    xfree(run.trace_times);
+  }
+
+  xfree(reference.trace_tags);
+  xfree(reference.trace_times);
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return failed;
+}
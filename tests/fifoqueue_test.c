@@ -0,0 +1,216 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * Checks the Fifoqueue ring buffer against a plain array. Random runs of puts
+ * and gets move the front of the queue around the ring, so that the contents
+ * wrap past its end, while the queue grows from FIFOQUEUE_INITIAL_SIZE to
+ * thousands of entries and (with shrinking on) back down. Every get and every
+ * look at the front must give what the array says, and the ring must stay a
+ * power of two that holds the queue. A queue in an arena is filled and
+ * drained over and over with shrinking on, and must neither shrink nor use
+ * more of the arena after the first round. Prints PASS and exits with 0, or
+ * prints what went wrong and exits with 1.
+ *
+ * Build and run from the top of the tree:
+ *
+ *   gcc -O2 -I. -o fifoqueue_test tests/fifoqueue_test.c simlib.c -lm
+ *   ./fifoqueue_test
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "simlib.h"
+
+/******************************************************************************/
+
+#define FIFOQUEUE_TEST_SEED 400099173
+#define FIFOQUEUE_TEST_ROUNDS 40
+#define FIFOQUEUE_TEST_MAX_SIZE 5000
+#define FIFOQUEUE_TEST_ARENA_SIZE 1000
+
+static int fifoqueue_test_failed = 0;
+
+static void
+fifoqueue_test_check(int ok, const char * what, long int step)
+{
+  if (!ok && !fifoqueue_test_failed) {
+    printf("FAIL: %s at step %ld.\n", what, step);
+    fifoqueue_test_failed = 1;
+  }
+}
+
+/*
+ * Put and get at random on a queue, with the contents kept in order in a
+ * plain array as well. Each round drifts towards a random target size, so the
+ * ring is grown and (if shrink is set) halved many times.
+ */
+
+static void
+fifoqueue_test_random(int shrink)
+{
+  Rand_Stream_Ptr stream;
+  Fifoqueue_Ptr queue;
+  uintptr_t * model, next_value = 1;
+  long int model_front = 0, model_back = 0, model_capacity, step = 0;
+  int round, target, largest = 0, shrunk = 0, capacity;
+  double put_probability;
+  void * content;
+
+  stream = rand_stream_new(FIFOQUEUE_TEST_SEED);
+  model_capacity = 4 * FIFOQUEUE_TEST_MAX_SIZE;
+  model = (uintptr_t *) xmalloc(model_capacity * sizeof(uintptr_t));
+  queue = fifoqueue_new();
+  fifoqueue_set_shrink(queue, shrink);
+
+  for (round = 0; round < FIFOQUEUE_TEST_ROUNDS; round++) {
+    target = (int) (FIFOQUEUE_TEST_MAX_SIZE *
+		    rand_stream_uniform_generator(stream));
+    put_probability = fifoqueue_size(queue) < target ? 0.75 : 0.25;
+
+    while ((put_probability > 0.5 && fifoqueue_size(queue) < target) ||
+	   (put_probability < 0.5 && fifoqueue_size(queue) > target)) {
+      step++;
+      capacity = queue->capacity;
+      if (rand_stream_uniform_generator(stream) < put_probability) {
+	if (model_back == model_capacity) {
+	  model_capacity *= 2;
+	  model = (uintptr_t *)
+	    xrealloc(model, model_capacity * sizeof(uintptr_t));
+	}
+	fifoqueue_put(queue, (void *) next_value);
+	model[model_back++] = next_value++;
+      }
+      else {
+	content = fifoqueue_get(queue);
+	if (model_front == model_back)
+	  fifoqueue_test_check(content == NULL,
+			       "get from an empty queue is not NULL", step);
+	else
+	  fifoqueue_test_check(content == (void *) model[model_front++],
+			       "get gives the wrong entry", step);
+      }
+      if (queue->capacity < capacity)
+	shrunk = 1;
+      if (queue->capacity > largest)
+	largest = queue->capacity;
+
+      fifoqueue_test_check(fifoqueue_size(queue) == model_back - model_front,
+			   "size is wrong", step);
+      fifoqueue_test_check(fifoqueue_see_front(queue) ==
+			   (model_front == model_back ? NULL :
+			    (void *) model[model_front]),
+			   "front is wrong", step);
+      fifoqueue_test_check(queue->capacity >= FIFOQUEUE_INITIAL_SIZE &&
+			   (queue->capacity & (queue->capacity - 1)) == 0 &&
+			   queue->size <= queue->capacity &&
+			   queue->front < queue->capacity,
+			   "ring is inconsistent", step);
+      if (shrink)
+	fifoqueue_test_check(queue->capacity <= FIFOQUEUE_INITIAL_SIZE ||
+			     queue->size >= queue->capacity / 4,
+			     "ring was not shrunk", step);
+    }
+  }
+
+  while (model_front < model_back) {
+    step++;
+    fifoqueue_test_check(fifoqueue_get(queue) == (void *) model[model_front++],
+			 "get gives the wrong entry while draining", step);
+  }
+  fifoqueue_test_check(fifoqueue_get(queue) == NULL,
+		       "get from a drained queue is not NULL", step);
+  fifoqueue_test_check(shrunk == shrink, shrink ? "ring never shrank" :
+		       "ring shrank with shrinking off", step);
+
+  printf("%s: %ld steps, largest ring %d, last ring %d\n",
+	 shrink ? "shrinking" : "growing", step, largest, queue->capacity);
+
+  fifoqueue_free(queue);
+  xfree(model);
+  xfree(stream);
+}
+
+/*
+ * Fill and drain a queue in an arena, with something else allocated in the
+ * arena after every put so that no ring is ever at the top of it.
+ */
+
+static void
+fifoqueue_test_arena(void)
+{
+  Arena_Ptr arena;
+  Fifoqueue_Ptr queue;
+  size_t first_peak = 0;
+  int round, i, capacity = 0;
+
+  arena = arena_new();
+  queue = fifoqueue_new_in_arena(arena);
+  fifoqueue_set_shrink(queue, 1);
+
+  for (round = 0; round < FIFOQUEUE_TEST_ROUNDS; round++) {
+    for (i = 0; i < FIFOQUEUE_TEST_ARENA_SIZE; i++)
+      fifoqueue_put(queue, (void *) (uintptr_t) (i + 1));
+    if (round == 0)
+      capacity = queue->capacity;
+    for (i = 0; i < FIFOQUEUE_TEST_ARENA_SIZE; i++)
+      if (fifoqueue_get(queue) != (void *) (uintptr_t) (i + 1))
+	fifoqueue_test_check(0, "arena queue gives the wrong entry", round);
+    fifoqueue_test_check(queue->capacity == capacity,
+			 "arena queue changed its ring size", round);
+    arena_alloc(arena, sizeof(void *));
+    if (round == 0)
+      first_peak = arena_peak_bytes(arena);
+  }
+
+  printf("arena: ring %d, peak bytes %lu after the first round, %lu after "
+	 "%d\n", queue->capacity, (unsigned long) first_peak,
+	 (unsigned long) arena_peak_bytes(arena), FIFOQUEUE_TEST_ROUNDS);
+  fifoqueue_test_check(arena_peak_bytes(arena) <= first_peak +
+		       FIFOQUEUE_TEST_ROUNDS * ARENA_ALIGNMENT,
+		       "arena queue keeps taking new rings", round);
+
+  arena_release(arena);
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char ** argv)
+{
+  (void) argc;
+  (void) argv;
+
+  fifoqueue_test_random(0);
+  fifoqueue_test_random(1);
+  fifoqueue_test_arena();
+
+  printf("%s\n", fifoqueue_test_failed ? "FAIL" : "PASS");
+  return fifoqueue_test_failed;
+}
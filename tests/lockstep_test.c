@@ -0,0 +1,256 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+/*
+ * Checks that the lockstep engine gives the same totals as the event engine.
+ * Every job of a small sweep is first run by the event engine through
+ * replication_run_all(). The seeds of each sweep point are then run by
+ * lockstep_run() directly, a few lanes at a time, and again through
+ * replication_run_all() with config.lockstep set. Every replication must end
+ * with the same arrival count, number of packets processed and accumulated
+ * delay at each switch. Prints PASS and exits with 0, or prints what differs
+ * and exits with 1.
+ *
+ * Build and run from the top of the tree:
+ *
+ *   gcc -O2 -pthread -I. -o lockstep_test tests/lockstep_test.c \
+ *       $(ls *.c | grep -v '^main\.c$') -lm
+ *   ./lockstep_test
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simlib.h"
+#include "main.h"
+#include "config.h"
+#include "packet_table.h"
+#include "topology.h"
+#include "lockstep.h"
+#include "replication.h"
+#include "cleanup_memory.h"
+
+/******************************************************************************/
+
+static char * lockstep_test_args[] =
+  {"lockstep_test", "--runlength=5000", "--p12_cutoff=0.5,0.99",
+   "--random_seed_list=400050636,400099173,225,1,7,31337,123456789,"
+   "2718281,3141592,42,99991"};
+
+#define LOCKSTEP_TEST_ARG_COUNT \
+  ((int) (sizeof(lockstep_test_args)/sizeof(lockstep_test_args[0])))
+
+/*
+ * Lane counts that lockstep_run() is tried with. They do not all divide the
+ * number of seeds, so the last group of a sweep point is a short one.
+ */
+
+static const int lockstep_test_lanes[] = {1, 3, 4, LOCKSTEP_MAX_LANES};
+
+#define LOCKSTEP_TEST_LANE_COUNT \
+  ((int) (sizeof(lockstep_test_lanes)/sizeof(lockstep_test_lanes[0])))
+
+typedef struct _lockstep_test_totals_
+{
+  int switch_count;
+  Switch_Totals * totals;	/* [job * MAX_SWITCHES + switch] */
+} Lockstep_Test_Totals;
+
+/******************************************************************************/
+
+/*
+ * The Replication_Commit of replication_run_all(). Keeps the totals of each
+ * job.
+ */
+
+static void
+lockstep_test_commit(long int job, int switch_count, Switch_Totals * totals,
+		     void * ctx)
+{
+  Lockstep_Test_Totals * kept = (Lockstep_Test_Totals *) ctx;
+
+  kept->switch_count = switch_count;
+  memcpy(&kept->totals[job * MAX_SWITCHES], totals,
+	 switch_count * sizeof(Switch_Totals));
+}
+
+/*
+ * Compare the totals of one job with those of the event engine. Returns 1 if
+ * they differ.
+ */
+
+static int
+lockstep_test_compare(const char * engine, long int job, int switch_count,
+		      const Switch_Totals * expected,
+		      const Switch_Totals * totals)
+{
+  int s, failed = 0;
+
+  for (s = 0; s < switch_count; s++)
+    if (totals[s].arrival_count != expected[s].arrival_count ||
+	totals[s].number_of_packets_processed !=
+	expected[s].number_of_packets_processed ||
+	totals[s].accumulated_delay != expected[s].accumulated_delay ||
+	totals[s].random_seed != expected[s].random_seed) {
+      printf("FAIL: %s job %ld (seed %u) SW%d: arrivals %ld / %ld, "
+	     "processed %ld / %ld, delay %.17g / %.17g\n", engine, job,
+	     expected[s].random_seed, s + 1, totals[s].arrival_count,
+	     expected[s].arrival_count, totals[s].number_of_packets_processed,
+	     expected[s].number_of_packets_processed,
+	     totals[s].accumulated_delay, expected[s].accumulated_delay);
+      failed = 1;
+    }
+
+  return failed;
+}
+
+/*
+ * Run the seeds of every sweep point with lockstep_run(), lanes at a time,
+ * the way a replication worker does, and compare them with expected. Returns
+ * 1 if any of them differ.
+ */
+
+static int
+lockstep_test_run(Config_Ptr config, int lanes,
+		  const Lockstep_Test_Totals * expected)
+{
+  Simulation_Run_Ptr simulation_run;
+  Simulation_Run_Data data;
+  Lockstep_Ptr lockstep;
+  Switch_Totals results[LOCKSTEP_MAX_LANES][MAX_SWITCHES];
+  Switch_Totals * totals[LOCKSTEP_MAX_LANES];
+  unsigned seeds[LOCKSTEP_MAX_LANES];
+  double packet_arrival_rate[3];
+  double p12_cutoff;
+  char engine[64];
+  int seed_count = config->random_seed_list.count;
+  long int point, job;
+  int first, count, k, failed = 0;
+
+  memset(&data, 0, sizeof(data));
+  data.config = config;
+  data.packets = packet_table_new();
+
+  simulation_run = simulation_run_new();
+  simulation_run_attach_data(simulation_run, (void *) & data);
+
+  config_sweep_point(config, 0, packet_arrival_rate, &p12_cutoff);
+  topology_three_switch(&data.topology, packet_arrival_rate,
+			config->packet_xmt_time, p12_cutoff);
+  switches_new(simulation_run);
+
+  lockstep = lockstep_new();
+  for (k = 0; k < LOCKSTEP_MAX_LANES; k++)
+    totals[k] = results[k];
+  snprintf(engine, sizeof(engine), "lockstep_run() with %d lanes", lanes);
+
+  for (point = 0; point < config_sweep_count(config); point++) {
+    config_sweep_point(config, point, packet_arrival_rate, &p12_cutoff);
+    topology_three_switch(&data.topology, packet_arrival_rate,
+			  config->packet_xmt_time, p12_cutoff);
+    switches_reset(simulation_run);
+
+    for (first = 0; first < seed_count; first += lanes) {
+      count = seed_count - first < lanes ? seed_count - first : lanes;
+      for (k = 0; k < count; k++)
+	seeds[k] = (unsigned) config->random_seed_list.values[first + k];
+
+      lockstep_run(lockstep, &data, seeds, count, totals);
+
+      for (k = 0; k < count; k++) {
+	job = point * seed_count + first + k;
+	failed |= lockstep_test_compare(engine, job, data.topology.switch_count,
+					&expected->totals[job * MAX_SWITCHES],
+					totals[k]);
+      }
+    }
+  }
+
+  lockstep_free(lockstep);
+  cleanup_memory(simulation_run);
+
+  return failed;
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char ** argv)
+{
+  Config config;
+  Lockstep_Test_Totals expected, lockstep;
+  long int job, job_count;
+  int i, failed = 0;
+
+  (void) argc;
+  (void) argv;
+
+  config_init(&config);
+  config_load(&config, LOCKSTEP_TEST_ARG_COUNT, lockstep_test_args);
+  job_count = config_sweep_count(&config) * config.random_seed_list.count;
+
+  expected.totals = (Switch_Totals *)
+    xcalloc(job_count * MAX_SWITCHES, sizeof(Switch_Totals));
+  lockstep.totals = (Switch_Totals *)
+    xcalloc(job_count * MAX_SWITCHES, sizeof(Switch_Totals));
+
+  /*
+   * The event engine, on one thread.
+   */
+
+  config.lockstep = 0;
+  replication_run_all(&config, 1, 0, lockstep_test_commit, &expected);
+
+  for (i = 0; i < LOCKSTEP_TEST_LANE_COUNT; i++)
+    failed |= lockstep_test_run(&config, lockstep_test_lanes[i], &expected);
+
+  /*
+   * The lockstep engine through replication_run_all(), on one thread and on
+   * several.
+   */
+
+  config.lockstep = 4;
+  for (i = 1; i <= 3; i += 2) {
+    memset(lockstep.totals, 0,
+	   job_count * MAX_SWITCHES * sizeof(Switch_Totals));
+    replication_run_all(&config, i, 0, lockstep_test_commit, &lockstep);
+    for (job = 0; job < job_count; job++)
+      failed |= lockstep_test_compare("replication_run_all()", job,
+				      expected.switch_count,
+				      &expected.totals[job * MAX_SWITCHES],
+				      &lockstep.totals[job * MAX_SWITCHES]);
+  }
+
+  printf("%ld jobs, %d switches\n", job_count, expected.switch_count);
+  printf("%s\n", failed ? "FAIL" : "PASS");
+
+  xfree(lockstep.totals);
+  xfree(expected.totals);
+  config_free(&config);
+
+  return failed;
+}
@@ -0,0 +1,197 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * Checks the next hops drawn from routing tables against their
+ * probabilities. Alias tables with 8 to 64 next hops are built for several
+ * shapes of probabilities: rising, falling geometrically, and one next hop
+ * taking half. A scanned table with ROUTING_SCAN_MAX_HOPS next hops is checked
+ * as well. Each table draws ROUTING_TEST_DRAWS next hops with
+ * routing_table_choose(), and the count of every next hop must be within
+ * ROUTING_TEST_SIGMAS standard deviations of what its probability gives, plus
+ * ROUTING_TEST_LEVELS values of the uniform generator for the resolution of
+ * the draw. Prints PASS and exits with 0, or prints what is out of range and
+ * exits with 1.
+ *
+ * Build and run from the top of the tree:
+ *
+ *   gcc -O2 -pthread -I. -o routing_test tests/routing_test.c \
+ *       $(ls *.c | grep -v '^main\.c$') -lm
+ *   ./routing_test
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "simlib.h"
+#include "main.h"
+#include "routing.h"
+
+/******************************************************************************/
+
+#define ROUTING_TEST_SEED 400050636
+#define ROUTING_TEST_DRAWS 2000000L
+#define ROUTING_TEST_SIGMAS 5.0
+#define ROUTING_TEST_LEVELS 4.0
+
+typedef enum {ROUTING_TEST_RISING, ROUTING_TEST_GEOMETRIC,
+	      ROUTING_TEST_HALF} Routing_Test_Shape;
+
+static const char * routing_test_shape_names[] = {
+  "rising", "geometric", "half"
+};
+
+static const int routing_test_hop_counts[] = {
+  ROUTING_SCAN_MAX_HOPS, 8, 13, 32, MAX_NEXT_HOPS
+};
+
+#define ROUTING_TEST_HOP_COUNT_COUNT \
+  ((int) (sizeof(routing_test_hop_counts)/sizeof(routing_test_hop_counts[0])))
+
+/******************************************************************************/
+
+/*
+ * Fill in the next hops of a switch with probabilities of the given shape.
+ * The next hops are numbered backwards, so that they are not the same as the
+ * columns of the table.
+ */
+
+static void
+routing_test_config(Switch_Config * config, int count,
+		    Routing_Test_Shape shape)
+{
+  double sum = 0.0;
+  int k;
+
+  config->next_hop_count = count;
+  for (k = 0; k < count; k++) {
+    config->next_hop[k] = count - 1 - k;
+    switch (shape) {
+    case ROUTING_TEST_RISING:
+      config->next_hop_probability[k] = k + 1;
+      break;
+    case ROUTING_TEST_GEOMETRIC:
+      config->next_hop_probability[k] = pow(0.9, k);
+      break;
+    default:
+      config->next_hop_probability[k] = k == 0 ? count - 1 : 1;
+      break;
+    }
+    sum += config->next_hop_probability[k];
+  }
+  for (k = 0; k < count; k++)
+    config->next_hop_probability[k] /= sum;
+}
+
+/*
+ * Draw from one table and compare the counts with the probabilities. Returns
+ * nonzero if any next hop is out of range.
+ */
+
+static int
+routing_test_table(Simulation_Run_Ptr simulation_run, int count,
+		   Routing_Test_Shape shape)
+{
+  Switch_Config config;
+  Routing_Table table;
+  long int drawn[MAX_NEXT_HOPS];
+  double expected, allowed, worst = 0.0;
+  long int i;
+  int k, hop, failed = 0;
+
+  routing_test_config(&config, count, shape);
+  routing_table_build(&table, &config);
+
+  for (k = 0; k < count; k++)
+    drawn[k] = 0;
+  for (i = 0; i < ROUTING_TEST_DRAWS; i++) {
+    hop = routing_table_choose(simulation_run, &table);
+    if (hop < 0 || hop >= count) {
+      printf("FAIL: %s table with %d next hops gave next hop %d.\n",
+	     routing_test_shape_names[shape], count, hop);
+      return 1;
+    }
+    drawn[hop]++;
+  }
+
+  for (k = 0; k < count; k++) {
+    expected = ROUTING_TEST_DRAWS * config.next_hop_probability[k];
+    allowed = ROUTING_TEST_SIGMAS *
+      sqrt(expected * (1.0 - config.next_hop_probability[k])) +
+      ROUTING_TEST_LEVELS * ROUTING_TEST_DRAWS / RAND_STREAM_MAX;
+    if (fabs(drawn[config.next_hop[k]] - expected) > allowed) {
+      printf("FAIL: %s table with %d next hops drew next hop %d %ld times, "
+	     "expected %.0f +/- %.0f.\n", routing_test_shape_names[shape],
+	     count, config.next_hop[k], drawn[config.next_hop[k]], expected,
+	     allowed);
+      failed = 1;
+    }
+    if (fabs(drawn[config.next_hop[k]] - expected) / allowed > worst)
+      worst = fabs(drawn[config.next_hop[k]] - expected) / allowed;
+  }
+
+  printf("%s, %d next hops (%s): worst error %.2f of allowed\n",
+	 routing_test_shape_names[shape], count,
+	 table.use_alias ? "alias" : "scan", worst);
+  return failed;
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char ** argv)
+{
+  Simulation_Run_Ptr simulation_run;
+  FILE * discard;
+  int shape, i, failed = 0;
+
+  (void) argc;
+  (void) argv;
+
+  simulation_run = simulation_run_new();
+  simulation_run_random_initialize(simulation_run, ROUTING_TEST_SEED);
+
+  discard = fopen("/dev/null", "w");
+  if (discard == NULL) {
+    printf("Error: Cannot open /dev/null.\n");
+    exit(1);
+  }
+  simulation_run_set_output(simulation_run, discard);
+
+  for (shape = ROUTING_TEST_RISING; shape <= ROUTING_TEST_HALF; shape++)
+    for (i = 0; i < ROUTING_TEST_HOP_COUNT_COUNT; i++)
+      if (routing_test_table(simulation_run, routing_test_hop_counts[i],
+			     (Routing_Test_Shape) shape))
+	failed = 1;
+
+  simulation_run_free_memory(simulation_run);
+  fclose(discard);
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return failed;
+}
@@ -0,0 +1,216 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+ * Checks that simulation_runs on different threads share no state. Each
+ * seed is run once on its own, then all of them at the same time, one per
+ * thread. Every simulation_run has its own event ids and random number
+ * stream, so each seed must end with the same next event id, the same number
+ * of events, the same switch statistics and the same next random numbers
+ * either way. Prints PASS and exits with 0, or prints what differs and exits
+ * with 1.
+ *
+ * Build and run from the top of the tree:
+ *
+ *   gcc -O2 -pthread -I. -o thread_test tests/thread_test.c \
+ *       $(ls *.c | grep -v '^main\.c$') -lm
+ *   ./thread_test
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "simlib.h"
+#include "main.h"
+#include "config.h"
+#include "packet_arrival.h"
+#include "packet_table.h"
+#include "topology.h"
+#include "static_topology.h"
+#include "event_dispatch.h"
+#include "cleanup_memory.h"
+
+/******************************************************************************/
+
+#define THREAD_TEST_RUNLENGTH 20000
+#define THREAD_TEST_DRAWS 8
+
+static const unsigned thread_test_seeds[] = {400050636, 400099173, 225};
+
+#define THREAD_TEST_SEED_COUNT \
+  ((int) (sizeof(thread_test_seeds)/sizeof(thread_test_seeds[0])))
+
+typedef struct _thread_test_result_
+{
+  unsigned seed;
+  long int next_event_id;
+  long int events_executed;
+  long int arrival_count[MAX_SWITCHES];
+  long int number_of_packets_processed[MAX_SWITCHES];
+  double accumulated_delay[MAX_SWITCHES];
+  double draws[THREAD_TEST_DRAWS];
+} Thread_Test_Result;
+
+/******************************************************************************/
+
+static int
+run_length_reached(Simulation_Run_Ptr simulation_run, void * ctx)
+{
+  Simulation_Run_Data_Ptr data = (Simulation_Run_Data_Ptr) ctx;
+
+  (void) simulation_run;
+  return data->switches[0].number_of_packets_processed >=
+    data->config->runlength;
+}
+
+/*
+ * Run the first sweep point of the default configuration with the seed of
+ * result, the way a replication worker does, and fill in the rest of result.
+ */
+
+static void *
+thread_test_run(void * ptr)
+{
+  Thread_Test_Result * result = (Thread_Test_Result *) ptr;
+  Simulation_Run_Ptr simulation_run;
+  Simulation_Run_Data data;
+  Config config;
+  double packet_arrival_rate[3];
+  double p12_cutoff;
+  FILE * discard;
+  Switch_Ptr sw;
+  int s, k;
+
+  config_init(&config);
+  config.runlength = THREAD_TEST_RUNLENGTH;
+
+  memset(&data, 0, sizeof(data));
+  data.config = &config;
+  data.packets = packet_table_new();
+
+  simulation_run = simulation_run_new();
+  simulation_run_attach_data(simulation_run, (void *) & data);
+
+  discard = fopen("/dev/null", "w");
+  if (discard == NULL) {
+    printf("Error: Cannot open /dev/null.\n");
+    exit(1);
+  }
+  simulation_run_set_output(simulation_run, discard);
+
+  config_sweep_point(&config, 0, packet_arrival_rate, &p12_cutoff);
+  topology_three_switch(&data.topology, packet_arrival_rate,
+			config.packet_xmt_time, p12_cutoff);
+  switches_new(simulation_run);
+  switches_reset(simulation_run);
+
+  data.random_seed = result->seed;
+  simulation_run_random_initialize(simulation_run, data.random_seed);
+
+#ifdef STATIC_TOPOLOGY
+  static_topology_start(simulation_run);
+#else
+  for (s = 0; s < data.topology.switch_count; s++) {
+    sw = &data.switches[s];
+    if (sw->config->packet_arrival_rate > 0)
+      schedule_packet_arrival_event(simulation_run,
+	    simulation_run_get_sim_time(simulation_run), sw);
+  }
+#endif
+
+#if defined(STATIC_TOPOLOGY)
+  run_events_static(simulation_run, run_length_reached, (void *) &data);
+#elif defined(TYPED_EVENT_DISPATCH)
+  run_events_by_kind(simulation_run, run_length_reached, (void *) &data);
+#else
+  simulation_run_run_until(simulation_run, -1.0, 0, run_length_reached,
+			   (void *) &data);
+#endif
+
+  result->next_event_id = simulation_run->next_event_id;
+  result->events_executed = simulation_run_events_executed(simulation_run);
+  for (s = 0; s < data.topology.switch_count; s++) {
+    sw = &data.switches[s];
+    result->arrival_count[s] = sw->arrival_count;
+    result->number_of_packets_processed[s] = sw->number_of_packets_processed;
+    result->accumulated_delay[s] = sw->accumulated_delay;
+  }
+  for (k = 0; k < THREAD_TEST_DRAWS; k++)
+    result->draws[k] = simulation_run_uniform_generator(simulation_run);
+
+  cleanup_memory(simulation_run);
+  fclose(discard);
+  config_free(&config);
+
+  return NULL;
+}
+
+/******************************************************************************/
+
+int
+main(int argc, char ** argv)
+{
+  Thread_Test_Result serial[THREAD_TEST_SEED_COUNT];
+  Thread_Test_Result threaded[THREAD_TEST_SEED_COUNT];
+  pthread_t threads[THREAD_TEST_SEED_COUNT];
+  int i, failed = 0;
+
+  (void) argc;
+  (void) argv;
+  memset(serial, 0, sizeof(serial));
+  memset(threaded, 0, sizeof(threaded));
+
+  for (i = 0; i < THREAD_TEST_SEED_COUNT; i++) {
+    serial[i].seed = threaded[i].seed = thread_test_seeds[i];
+    thread_test_run(&serial[i]);
+  }
+
+  for (i = 0; i < THREAD_TEST_SEED_COUNT; i++)
+    if (pthread_create(&threads[i], NULL, thread_test_run,
+		       (void *) & threaded[i]) != 0) {
+      printf("Error: Cannot create test thread %d.\n", i);
+      exit(1);
+    }
+  for (i = 0; i < THREAD_TEST_SEED_COUNT; i++)
+    pthread_join(threads[i], NULL);
+
+  for (i = 0; i < THREAD_TEST_SEED_COUNT; i++) {
+    printf("seed %u: next event id %ld / %ld, events %ld / %ld\n",
+	   serial[i].seed, serial[i].next_event_id, threaded[i].next_event_id,
+	   serial[i].events_executed, threaded[i].events_executed);
+    if (memcmp(&serial[i], &threaded[i], sizeof(Thread_Test_Result)) != 0) {
+      printf("FAIL: seed %u differs when run on its own thread.\n",
+	     serial[i].seed);
+      failed = 1;
+    }
+  }
+
+  printf("%s\n", failed ? "FAIL" : "PASS");
+  return failed;
+}
@@ -0,0 +1,180 @@
+
+/*
+ * 
+ * Simulation_Run of A Single Server Queueing System
+ * 
+ * Copyright (C) 2014 Terence D. Todd Hamilton, Ontario, CANADA,
+ * todd@mcmaster.ca
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ */
+
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "main.h"
+#include "packet_table.h"
+#include "routing.h"
+#include "topology.h"
+
+/******************************************************************************/
+
+/*
+ * Build the topology of the original model, with the given arrival rates and
+ * link transmission times of SW1, SW2 and SW3. Packets from SW1 are forwarded
+ * to SW2 with probability p12_cutoff and to SW3 otherwise. SW2 and SW3 have
+ * sources of their own and send their packets out of the network.
+ */
+
+void
+topology_three_switch(Topology_Ptr topology, const double * packet_arrival_rate,
+		      const double * packet_xmt_time, double p12_cutoff)
+{
+  Switch_Config * sw;
+
+  topology->switch_count = 3;
+
+  sw = &topology->switches[0];
+  sw->packet_arrival_rate = packet_arrival_rate[0];
+  sw->packet_xmt_time = packet_xmt_time[0];
+  sw->next_hop_count = 2;
+  sw->next_hop[0] = 1;
+  sw->next_hop_probability[0] = p12_cutoff;
+  sw->next_hop[1] = 2;
+  sw->next_hop_probability[1] = 1.0 - p12_cutoff;
+
+  sw = &topology->switches[1];
+  sw->packet_arrival_rate = packet_arrival_rate[1];
+  sw->packet_xmt_time = packet_xmt_time[1];
+  sw->next_hop_count = 0;
+
+  sw = &topology->switches[2];
+  sw->packet_arrival_rate = packet_arrival_rate[2];
+  sw->packet_xmt_time = packet_xmt_time[2];
+  sw->next_hop_count = 0;
+}
+
+/*
+ * Check that a topology can be simulated. The program stops with an error
+ * message if it cannot.
+ */
+
+void
+topology_check(Topology_Ptr topology)
+{
+  Switch_Config * sw;
+  double sum;
+  int i, k;
+
+  if (topology->switch_count < 1 || topology->switch_count > MAX_SWITCHES) {
+    printf("Error: A topology must have from 1 to %d switches.\n",
+	   MAX_SWITCHES);
+    exit(1);
+  }
+
+  for (i=0; i<topology->switch_count; i++) {
+    sw = &topology->switches[i];
+    if (sw->next_hop_count < 0 || sw->next_hop_count > MAX_NEXT_HOPS) {
+      printf("Error: SW%d must have from 0 to %d next hops.\n",
+	     i+1, MAX_NEXT_HOPS);
+      exit(1);
+    }
+    for (k=0; k<sw->next_hop_count; k++)
+      if (sw->next_hop[k] < 0 || sw->next_hop[k] >= topology->switch_count ||
+	  sw->next_hop[k] == i) {
+	printf("Error: SW%d has an invalid next hop %d.\n",
+	       i+1, sw->next_hop[k]+1);
+	exit(1);
+      }
+
+    sum = 0.0;
+    for (k=0; k<sw->next_hop_count; k++) {
+      if (sw->next_hop_probability[k] < 0.0) {
+	printf("Error: SW%d has a negative next hop probability.\n", i+1);
+	exit(1);
+      }
+      sum += sw->next_hop_probability[k];
+    }
+    if (sw->next_hop_count > 0 && fabs(sum - 1.0) > 1e-9) {
+      printf("Error: The next hop probabilities of SW%d add up to %f.\n",
+	     i+1, sum);
+      exit(1);
+    }
+  }
+}
+
+/*
+ * Set up the switches of a simulation_run from the topology in its data. This
+ * is done once, when the simulation_run is created. The links are allocated
+ * from the simulation_run arena, so they are freed along with it.
+ */
+
+void
+switches_new(Simulation_Run_Ptr simulation_run)
+{
+  Simulation_Run_Data_Ptr data;
+  Switch_Ptr sw;
+  int i;
+
+  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+  topology_check(&data->topology);
+
+  for (i=0; i<data->topology.switch_count; i++) {
+    sw = &data->switches[i];
+    sw->id = i;
+    sw->config = &data->topology.switches[i];
+    snprintf(sw->name, sizeof(sw->name), "SW%d", i+1);
+    snprintf(sw->arrival_description, sizeof(sw->arrival_description),
+	     "%s Packet Arrival", sw->name);
+    snprintf(sw->forward_description, sizeof(sw->forward_description),
+	     "%s Forwarded Packet Arrival", sw->name);
+    snprintf(sw->end_description, sizeof(sw->end_description),
+	     "%s Packet Xmt End", sw->name);
+    sw->link = server_new_in_arena(simulation_run_arena(simulation_run));
+  }
+}
+
+/*
+ * Get the switches ready for a replication: empty their buffers, free their
+ * links, rebuild their routing tables and clear their statistics. The
+ * topology may have been changed since the last replication, but not its
+ * number of switches.
+ */
+
+void
+switches_reset(Simulation_Run_Ptr simulation_run)
+{
+  Simulation_Run_Data_Ptr data;
+  Switch_Ptr sw;
+  int i;
+
+  data = (Simulation_Run_Data_Ptr) simulation_run_data(simulation_run);
+  topology_check(&data->topology);
+
+  for (i=0; i<data->topology.switch_count; i++) {
+    sw = &data->switches[i];
+    sw->xmt_time = SIM_TIME_FROM_SECONDS(sw->config->packet_xmt_time);
+    routing_table_build(&sw->routing, sw->config);
+    packet_queue_init(&sw->buffer);
+    server_reset(sw->link);
+    sw->blip_counter = 0;
+    sw->arrival_count = 0;
+    sw->number_of_packets_processed = 0;
+    sw->accumulated_delay = 0.0;
+  }
+}
+